@@ -0,0 +1,524 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+#include <cstring>   // std::memcpy
+#include <limits>    // std::numeric_limits
+#include <queue>     // std::priority_queue
+#include <vector>
+
+#include <lol/real>
+#include <lol/math>
+
+#include "analysis.h"
+#include "pool.h"
+#include "taylor.h"
+
+using lol::real;
+
+// Evaluate the scheme exactly as the generated code does, using the native
+// type T, and compute a running error bound alongside, in the spirit of
+// Higham’s Algorithm 5.1 in “Accuracy and Stability of Numerical
+// Algorithms”: each rounding contributes at most u times the computed
+// result, and errors on the operands propagate to first order.
+template<typename T>
+static T eval_with_bound(eval_scheme const &scheme, std::vector<real> const &coeffs,
+                         real const &x, real const &u, real &bound)
+{
+    using op = eval_scheme::op;
+    using operand = eval_scheme::operand;
+
+    std::vector<T> v(scheme.vars().size());
+    std::vector<real> e(scheme.vars().size());
+    T const tx = T(x);
+
+    auto value = [&](operand const &o) -> T
+    {
+        return o.kind == operand::x ? tx
+             : o.kind == operand::coeff ? T(coeffs[o.index]) : v[o.index];
+    };
+
+    auto error = [&](operand const &o) -> real
+    {
+        return o.kind == operand::var ? e[o.index] : real::R_0();
+    };
+
+    for (auto const &o : scheme.ops())
+    {
+        T const a = value(o.a), b = value(o.b);
+        real const ea = error(o.a), eb = error(o.b);
+
+        switch (o.kind)
+        {
+        case op::set:
+            v[o.dst] = a;
+            e[o.dst] = ea;
+            break;
+        case op::add:
+            v[o.dst] = a + b;
+            e[o.dst] = ea + eb + u * fabs(real(v[o.dst]));
+            break;
+        case op::mul:
+        case op::muladd:
+        {
+            T const t = a * b;
+            real et = fabs(real(a)) * eb + fabs(real(b)) * ea + ea * eb
+                    + u * fabs(real(t));
+            if (o.kind == op::mul)
+            {
+                v[o.dst] = t;
+                e[o.dst] = et;
+                break;
+            }
+            v[o.dst] = t + value(o.c);
+            e[o.dst] = et + error(o.c) + u * fabs(real(v[o.dst]));
+            break;
+        }
+        }
+    }
+
+    bound = error(scheme.result());
+    return value(scheme.result());
+}
+
+// Evaluate the scheme as the generated code does for the target: in its
+// arithmetic type, then converted to the storage type if that is narrower,
+// which adds half an ulp to the error bound.
+static real eval_target(eval_scheme const &scheme, std::vector<real> const &coeffs,
+                        real const &x, number_type type, real &bound)
+{
+    auto const &info = get_target_info(type);
+    real const u = ldexp(real::R_1(), -get_target_info(info.compute).mantissa);
+
+    real y;
+    switch (info.compute)
+    {
+    case number_type::float32:
+        y = real(eval_with_bound<float>(scheme, coeffs, x, u, bound)); break;
+    case number_type::float64:
+        y = real(eval_with_bound<double>(scheme, coeffs, x, u, bound)); break;
+    case number_type::long_double:
+    default:
+        y = real(eval_with_bound<long double>(scheme, coeffs, x, u, bound)); break;
+    }
+
+    if (info.compute != type)
+    {
+        bound += ulp(y, type) / 2;
+        y = round_to(y, type);
+    }
+    return y;
+}
+
+// Call check() on the inputs that the error budget uses: every input in
+// the range for 16-bit types, which are small enough for that, otherwise
+// evenly spaced samples. Returns whether these were all inputs.
+template<typename F>
+static bool for_each_input(real const &xmin, real const &xmax, number_type type,
+                           int samples, F const &check)
+{
+    if (get_target_info(type).bits == 16)
+    {
+        for (unsigned bits = 0; bits < 0x10000; ++bits)
+        {
+            real x;
+            if (decode16(bits, type, x) && x >= xmin && x <= xmax && bits != 0x8000)
+                check(x);
+        }
+        return true;
+    }
+
+    for (int i = 0; i < samples; ++i)
+        check(round_to(xmin + (xmax - xmin) * real(i) / real(samples - 1), type));
+    return false;
+}
+
+static error_budget compute_budget(eval_scheme const &scheme,
+                                   std::vector<real> const &coeffs,
+                                   expression const &func,
+                                   real const &xmin, real const &xmax,
+                                   number_type type, int samples)
+{
+    int const n = int(coeffs.size()) - 1;
+
+    error_budget ret;
+
+    auto check = [&](real const &x)
+    {
+        real exact = 0;
+        for (int j = n; j >= 0; --j)
+            exact = exact * x + coeffs[j];
+
+        real const fx = func.eval(x);
+        real const unit = ulp(fx, type);
+
+        real rounding;
+        real const y = eval_target(scheme, coeffs, x, type, rounding);
+
+        double const approximation = double(fabs(exact - fx) / unit);
+        double const total = double((fabs(exact - fx) + rounding) / unit);
+
+        ret.approximation = std::max(ret.approximation, approximation);
+        ret.rounding = std::max(ret.rounding, double(rounding / unit));
+        ret.observed = std::max(ret.observed, double(fabs(y - fx) / unit));
+        if (total > ret.total)
+        {
+            ret.total = total;
+            ret.worst_x = x;
+        }
+        ++ret.count;
+    };
+
+    ret.exhaustive = for_each_input(xmin, xmax, type, samples, check);
+    return ret;
+}
+
+// Coefficients exactly as they appear in the generated code
+static std::vector<real> rounded_coeffs(lol::polynomial<real> const &p,
+                                        eval_scheme const &scheme, number_type type)
+{
+    std::vector<real> ret;
+    for (int j = 0; j <= scheme.degree(); ++j)
+        ret.push_back(round_to(p[j], type));
+    return ret;
+}
+
+error_budget compute_error_budget(lol::polynomial<real> const &p,
+                                  eval_scheme const &scheme,
+                                  expression const &func,
+                                  real const &xmin, real const &xmax,
+                                  number_type type, int samples)
+{
+    auto const coeffs = rounded_coeffs(p, scheme, type);
+    return compute_budget(scheme, coeffs, func, xmin, xmax, type, samples);
+}
+
+int make_one_sided(lol::polynomial<real> &p, eval_scheme const &scheme,
+                   expression const &func, real const &xmin, real const &xmax,
+                   number_type type, bool upper, int samples)
+{
+    real const sign = upper ? real::R_1() : -real::R_1();
+    auto coeffs = rounded_coeffs(p, scheme, type);
+
+    // Moving c0 also changes the rounding errors a little, so repeat until
+    // the exact polynomial clears f by the rounding error bound everywhere
+    for (int pass = 0; pass < 4; ++pass)
+    {
+        real shift = 0;
+        for_each_input(xmin, xmax, type, samples, [&](real const &x)
+        {
+            real exact = 0;
+            for (int j = scheme.degree(); j >= 0; --j)
+                exact = exact * x + coeffs[j];
+
+            real rounding;
+            eval_target(scheme, coeffs, x, type, rounding);
+            shift = max(shift, sign * (func.eval(x) - exact) + rounding);
+        });
+
+        if (shift.is_zero())
+            break;
+
+        real const target = coeffs[0] + sign * shift;
+        real c0 = round_to(target, type);
+        if (sign * (c0 - target) < real::R_0())
+            c0 += sign * ulp(c0, type);
+        coeffs[0] = c0;
+        p.set(0, c0);
+    }
+
+    int ret = 0;
+    for_each_input(xmin, xmax, type, samples, [&](real const &x)
+    {
+        real rounding;
+        real const y = eval_target(scheme, coeffs, x, type, rounding);
+        if (sign * (y - func.eval(x)) < real::R_0())
+            ++ret;
+    });
+    return ret;
+}
+
+real error_bound_at(lol::polynomial<real> const &p, eval_scheme const &scheme,
+                    expression const &func, real const &x, number_type type)
+{
+    auto const coeffs = rounded_coeffs(p, scheme, type);
+
+    real exact = 0;
+    for (int j = scheme.degree(); j >= 0; --j)
+        exact = exact * x + coeffs[j];
+
+    real rounding;
+    eval_target(scheme, coeffs, x, type, rounding);
+    return fabs(exact - func.eval(x)) + rounding;
+}
+
+// Running error bound of the scheme for all x in an interval: the same
+// recurrence as eval_with_bound(), where each computed value lies within
+// its error bound of an exact value enclosed by an interval.
+static real rounding_bound(eval_scheme const &scheme, std::vector<real> const &coeffs,
+                           interval const &x, real const &u)
+{
+    using op = eval_scheme::op;
+    using operand = eval_scheme::operand;
+
+    std::vector<interval> v(scheme.vars().size());
+    std::vector<real> e(scheme.vars().size());
+
+    auto value = [&](operand const &o) -> interval
+    {
+        return o.kind == operand::x ? x
+             : o.kind == operand::coeff ? interval(coeffs[o.index]) : v[o.index];
+    };
+
+    auto error = [&](operand const &o) -> real
+    {
+        return o.kind == operand::var ? e[o.index] : real::R_0();
+    };
+
+    for (auto const &o : scheme.ops())
+    {
+        interval const a = value(o.a), b = value(o.b);
+        real const ea = error(o.a), eb = error(o.b);
+
+        switch (o.kind)
+        {
+        case op::set:
+            v[o.dst] = a;
+            e[o.dst] = ea;
+            break;
+        case op::add:
+            v[o.dst] = a + b;
+            e[o.dst] = ea + eb + u * (v[o.dst].mag() + ea + eb);
+            break;
+        case op::mul:
+        case op::muladd:
+        {
+            interval const t = a * b;
+            real const et0 = a.mag() * eb + b.mag() * ea + ea * eb;
+            real const et = et0 + u * (t.mag() + et0);
+            if (o.kind == op::mul)
+            {
+                v[o.dst] = t;
+                e[o.dst] = et;
+                break;
+            }
+            real const ec = error(o.c);
+            v[o.dst] = t + value(o.c);
+            e[o.dst] = et + ec + u * (v[o.dst].mag() + et + ec);
+            break;
+        }
+        }
+    }
+
+    return error(scheme.result());
+}
+
+// Doubles in increasing order, numbered by consecutive integers. Halving
+// a range of these numbers halves the number of inputs rather than the
+// width, so that the search reaches the tiny inputs near zero as fast as
+// any others.
+static int64_t to_ordinal(double x)
+{
+    int64_t i;
+    std::memcpy(&i, &x, sizeof(i));
+    return i < 0 ? std::numeric_limits<int64_t>::min() - i : i;
+}
+
+static double from_ordinal(int64_t i)
+{
+    i = i < 0 ? std::numeric_limits<int64_t>::min() - i : i;
+    double x;
+    std::memcpy(&x, &i, sizeof(x));
+    return x;
+}
+
+// Subintervals of at most this many inputs are checked exhaustively
+static int64_t const leaf_size = 64;
+
+// Stop when no subinterval can exceed the worst input by more than this
+// fraction, or after bounding this many subintervals
+static double const tolerance = 0.01;
+static int64_t const max_intervals = 1 << 20;
+
+bool can_find_worst_case(expression const &func)
+{
+    return bool(func.eval_as(taylor(real::R_0())));
+}
+
+bool find_worst_case(lol::polynomial<real> const &p, eval_scheme const &scheme,
+                     expression const &func, real const &xmin, real const &xmax,
+                     worst_case &ret)
+{
+    if (!can_find_worst_case(func))
+        return false;
+
+    number_type const type = number_type::float64;
+    auto const coeffs = rounded_coeffs(p, scheme, type);
+    int const n = scheme.degree();
+    real const u = ldexp(real::R_1(), -get_target_info(type).mantissa);
+
+    // Total error and actual error at x, in ulps of f(x)
+    auto check = [&](real const &x, double &total, double &observed)
+    {
+        real exact = 0;
+        for (int j = n; j >= 0; --j)
+            exact = exact * x + coeffs[j];
+
+        real const fx = func.eval(x);
+        real const unit = ulp(fx, type);
+
+        real rounding;
+        real const y = eval_target(scheme, coeffs, x, type, rounding);
+        total = double((fabs(exact - fx) + rounding) / unit);
+        observed = double(fabs(y - fx) / unit);
+    };
+
+    // Upper bound of the total error over [a, b]. With m the midpoint and
+    // h the half width, f(m + t) is its Taylor polynomial of degree n at m
+    // plus f⁽ⁿ⁺¹⁾(ξ)/(n+1)!·t^(n+1) for some ξ in [a, b], and p(m + t) is
+    // exactly a polynomial of degree n, so that the difference cancels
+    // coefficient by coefficient, as it does for each single input.
+    auto bound = [&](real const &a, real const &b) -> double
+    {
+        real const m = (a + b) / 2, h = (b - a) / 2;
+        auto const fm = func.eval_as(taylor::variable(interval(m), n + 1));
+        auto const fi = func.eval_as(taylor::variable(interval(a, b), n + 1));
+        if (!fm->valid || !fi->valid)
+            return std::numeric_limits<double>::infinity();
+
+        // Coefficients of p(m + t)
+        std::vector<real> q(coeffs);
+        for (int i = 0; i < n; ++i)
+            for (int j = n - 1; j >= i; --j)
+                q[j] += m * q[j + 1];
+
+        // Approximation error, and smallest |f| for the size of an ulp
+        real approximation = 0, spread = 0, hk = 1;
+        for (int k = 0; k <= n; ++k, hk *= h)
+        {
+            approximation += (interval(q[k]) - fm->coeff(k)).mag() * hk;
+            spread += k ? fm->coeff(k).mag() * hk : real::R_0();
+        }
+        approximation += fi->coeff(n + 1).mag() * hk;
+        spread += fi->coeff(n + 1).mag() * hk;
+        real const fmin = max(fi->coeff(0).mig(), fm->coeff(0).mig() - spread);
+
+        real const rounding = rounding_bound(scheme, coeffs, interval(a, b), u);
+        return double((approximation + rounding) / ulp(max(fmin, real::R_0()), type));
+    };
+
+    // A range of inputs, and the bound of its total error
+    struct node
+    {
+        int64_t lo, hi;
+        double upper;
+        bool operator <(node const &other) const { return upper < other.upper; }
+    };
+
+    // Results of the jobs of one round: bound of the subinterval, or exact
+    // maximum for the small ones, and the worst input tried
+    struct result
+    {
+        double upper, total, observed, max_observed;
+        real x;
+        int64_t count;
+    };
+
+    std::vector<node> batch;
+    std::vector<result> results;
+
+    // Bound the subintervals in parallel, at low priority since this can
+    // take a while; each one also checks its middle input.
+    worker_pool::client pool([&](int t)
+    {
+        node const &s = batch[t];
+        result &r = results[t];
+        r.total = r.max_observed = -1;
+        r.count = 0;
+
+        auto try_input = [&](int64_t i)
+        {
+            double total, observed;
+            real const x = real(from_ordinal(i));
+            check(x, total, observed);
+            if (total > r.total)
+                r.total = total, r.observed = observed, r.x = x;
+            r.max_observed = std::max(r.max_observed, observed);
+            ++r.count;
+        };
+
+        if (s.hi - s.lo < leaf_size)
+        {
+            for (int64_t i = s.lo; i <= s.hi; ++i)
+                try_input(i);
+        }
+        else
+        {
+            r.upper = bound(real(from_ordinal(s.lo)), real(from_ordinal(s.hi)));
+            try_input(s.lo + (s.hi - s.lo) / 2);
+        }
+        return t;
+    }, worker_pool::priority::batch);
+
+    // First and last double in the range
+    int64_t lo = to_ordinal(double(xmin)), hi = to_ordinal(double(xmax));
+    lo += real(from_ordinal(lo)) < xmin;
+    hi -= real(from_ordinal(hi)) > xmax;
+
+    ret = worst_case();
+    ret.total = -1;
+    std::priority_queue<node> queue;
+    batch.push_back(node { lo, hi, 0 });
+
+    while (!batch.empty())
+    {
+        results.resize(batch.size());
+        for (int t = 0; t < (int)batch.size(); ++t)
+            pool.push(t);
+        for (size_t t = 0; t < batch.size(); ++t)
+            pool.pop();
+
+        for (size_t t = 0; t < batch.size(); ++t)
+        {
+            result const &r = results[t];
+            if (r.total > ret.total)
+                ret.x = r.x, ret.total = r.total, ret.observed = r.observed;
+            ret.max_observed = std::max(ret.max_observed, r.max_observed);
+            ret.count += r.count;
+            ++ret.intervals;
+            if (batch[t].hi - batch[t].lo >= leaf_size)
+                queue.push(node { batch[t].lo, batch[t].hi, r.upper });
+        }
+
+        // Split the subintervals with the largest bounds, unless they
+        // cannot beat the worst input found so far
+        batch.clear();
+        while (!queue.empty() && batch.size() < size_t(4 * worker_pool::size())
+                && queue.top().upper > ret.total * (1 + tolerance)
+                && ret.intervals < max_intervals)
+        {
+            node const s = queue.top();
+            queue.pop();
+            int64_t const mid = s.lo + (s.hi - s.lo) / 2;
+            batch.push_back(node { s.lo, mid, 0 });
+            batch.push_back(node { mid + 1, s.hi, 0 });
+        }
+    }
+
+    ret.bound = std::max(ret.total, queue.empty() ? 0.0 : queue.top().upper);
+    ret.proven = ret.bound <= ret.total * (1 + tolerance);
+    return true;
+}
@@ -0,0 +1,97 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// Error analysis of the generated code
+// ------------------------------------
+//
+// The solver only knows about the approximation error of the polynomial
+// with infinitely precise coefficients. The code we emit rounds these
+// coefficients to the target type, then evaluates an evaluation scheme
+// with one rounding per operation. This module measures all of that.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <cstdint>
+
+#include "expression.h"
+#include "scheme.h"
+#include "target.h"
+
+struct error_budget
+{
+    // All errors are expressed in ulps of f(x) in the target type
+    double approximation = 0; // |p(x) - f(x)| with rounded coefficients
+    double rounding = 0;      // running error bound of the scheme
+    double total = 0;         // max of the sum of the above
+    double observed = 0;      // actual error of the scheme
+    lol::real worst_x;        // where the total error is the largest
+    int count = 0;            // number of inputs checked
+    bool exhaustive = false;  // whether these were all inputs in the range
+};
+
+// Inputs are sampled evenly over the range, except for 16-bit types whose
+// every input in the range is checked.
+error_budget compute_error_budget(lol::polynomial<lol::real> const &p,
+                                  eval_scheme const &scheme,
+                                  expression const &func,
+                                  lol::real const &xmin, lol::real const &xmax,
+                                  number_type type, int samples = 2048);
+
+// For one-sided approximations, where the solver keeps the polynomial
+// above f (if upper is true) or below it with exact arithmetic: move the
+// constant coefficient of p outwards by the error on the wrong side plus
+// the rounding error bound, rounded away from f in the target type.
+// Returns how many of the inputs of compute_error_budget() the generated
+// code still evaluates on the wrong side of f.
+int make_one_sided(lol::polynomial<lol::real> &p, eval_scheme const &scheme,
+                   expression const &func,
+                   lol::real const &xmin, lol::real const &xmax,
+                   number_type type, bool upper, int samples = 2048);
+
+// Bound on the total error of the generated code at a single point x, in
+// absolute terms: approximation error plus running rounding error bound.
+lol::real error_bound_at(lol::polynomial<lol::real> const &p,
+                         eval_scheme const &scheme,
+                         expression const &func,
+                         lol::real const &x, number_type type);
+
+struct worst_case
+{
+    // All errors are expressed in ulps of f(x) in double, and the total
+    // error is the same bound as in error_budget
+    lol::real x;              // input with the largest total error
+    double total = 0;         // total error at x
+    double observed = 0;      // actual error of the scheme at x
+    double bound = 0;         // no input has a larger total error
+    double max_observed = 0;  // largest actual error of all inputs tried
+    int64_t intervals = 0;    // number of subintervals bounded
+    int64_t count = 0;        // number of inputs evaluated
+    bool proven = false;      // whether bound is within 1% of total
+};
+
+// Branch-and-bound search for the largest total error of a double kernel
+// over every input in the range. Subintervals are bounded using a Taylor
+// model of f and an interval version of the running error bound, and are
+// split until none can exceed the worst input found so far. Returns false
+// if f uses functions that cannot be bounded over intervals, which
+// can_find_worst_case() tells beforehand.
+bool can_find_worst_case(expression const &func);
+bool find_worst_case(lol::polynomial<lol::real> const &p,
+                     eval_scheme const &scheme,
+                     expression const &func,
+                     lol::real const &xmin, lol::real const &xmax,
+                     worst_case &ret);
@@ -0,0 +1,285 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <lol/real>
+
+#include "bench.h"
+
+#if _WIN32
+#   define popen _popen
+#   define pclose _pclose
+#else
+#   include <csignal>    // SIGILL
+#   include <sys/wait.h> // WIFSIGNALED, WTERMSIG
+#endif
+
+using lol::real;
+
+static void write_benchmark(std::ostream &os, number_type type,
+                            real const &xmin, real const &xmax,
+                            std::vector<code_generator> const &kernels)
+{
+    std::string const t = get_target_info(type).name;
+
+    os << "// Benchmark generated by lolremez\n\n";
+    os << "#include <chrono>\n#include <cstdio>\n\n";
+
+    for (auto const &k : kernels)
+    {
+        k.emit_scalar(os);
+        os << '\n';
+    }
+
+    // The baseline measures the loop overhead, which is subtracted from
+    // the latency results.
+    os << "static " << t << " baseline(" << t << " x) { return x; }\n\n";
+
+    os << "static " << t << " const xmin = " << format_literal(xmin, type) << ";\n";
+    os << "static " << t << " const xmax = " << format_literal(xmax, type) << ";\n";
+    os << "static volatile " << t << " zero = 0;\n";
+    os << "static volatile " << t << " sink;\n\n";
+
+    os << "template<typename F> static double run(F f)\n{\n"
+       << "    double best = 1e30;\n"
+       << "    for (int n = 0; n < 7; ++n)\n    {\n"
+       << "        auto t0 = std::chrono::steady_clock::now();\n"
+       << "        f();\n"
+       << "        std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - t0;\n"
+       << "        best = t.count() < best ? t.count() : best;\n"
+       << "    }\n"
+       << "    return best;\n}\n\n";
+
+    // Latency: each input depends on the previous output through an
+    // operation the compiler cannot fold away.
+    os << "template<typename F> static double latency(F f)\n{\n"
+       << "    int const count = 1000000;\n"
+       << "    " << t << " const x0 = (xmin + xmax) / 2, k = zero;\n"
+       << "    return run([&]()\n    {\n"
+       << "        " << t << " x = x0, sum = 0;\n"
+       << "        for (int i = 0; i < count; ++i)\n        {\n"
+       << "            " << t << " y = f(x);\n"
+       << "            sum += y;\n"
+       << "            x = x0 + y * k;\n"
+       << "        }\n"
+       << "        sink = sum;\n"
+       << "    }) / count;\n}\n\n";
+
+    // Throughput: independent calls over an array, which the compiler is
+    // free to vectorise.
+    os << "template<typename F> static double throughput(F f)\n{\n"
+       << "    int const size = 1024, reps = 1000;\n"
+       << "    static " << t << " in[size], out[size];\n"
+       << "    for (int i = 0; i < size; ++i)\n"
+       << "        in[i] = xmin + (xmax - xmin) * i / (size - 1);\n"
+       << "    return run([&]()\n    {\n"
+       << "        for (int r = 0; r < reps; ++r)\n        {\n"
+       << "            for (int i = 0; i < size; ++i)\n"
+       << "                out[i] = f(in[i]);\n"
+       << "            sink = out[r % size];\n"
+       << "        }\n"
+       << "    }) / size / reps;\n}\n\n";
+
+    os << "int main()\n{\n"
+       << "    double const base = latency(baseline);\n";
+    for (size_t i = 0; i < kernels.size(); ++i)
+        os << "    std::printf(\"" << i << " %.3f %.3f\\n\", latency(" << kernels[i].name()
+           << ") - base, throughput(" << kernels[i].name() << "));\n";
+    os << "    return 0;\n}\n";
+}
+
+static std::string compiler_command()
+{
+    char const *cxx = getenv("CXX");
+    char const *cxxflags = getenv("CXXFLAGS");
+    return std::string(cxx ? cxx : "c++") + " -std=c++17 " + (cxxflags ? cxxflags : "-O2");
+}
+
+// The shell only looks for a bare file name in $PATH
+static std::string executable(std::string const &path)
+{
+    return (path.find_first_of("/\\") == std::string::npos ? "./" : "") + path + ".out";
+}
+
+bool run_benchmark(std::string const &path, number_type type,
+                   real const &xmin, real const &xmax,
+                   std::vector<code_generator> const &kernels,
+                   std::vector<bench_result> &results, std::string &compiler)
+{
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        write_benchmark(file, type, xmin, xmax, kernels);
+    }
+
+    std::string const exe = executable(path);
+    compiler = compiler_command();
+    std::string const build = compiler + " -o \"" + exe + "\" \"" + path + "\"";
+    if (system(build.c_str()) != 0)
+        return false;
+
+    FILE *p = popen(("\"" + exe + "\"").c_str(), "r");
+    if (!p)
+        return false;
+
+    char line[256];
+    size_t index;
+    double latency, throughput;
+    while (fgets(line, sizeof(line), p))
+    {
+        std::istringstream ss(line);
+        if (ss >> index >> latency >> throughput && index < kernels.size())
+            results.push_back(bench_result { kernels[index].scheme().name(),
+                                             latency, throughput });
+    }
+
+    return pclose(p) == 0 && results.size() == kernels.size();
+}
+
+// Instruction sets to check, and the compiler flags they need; the
+// program is built once for each, with SIMD_CHECK set to the index.
+struct simd_check_info
+{
+    simd_isa isa;
+    char const *name, *flags;
+};
+
+static simd_check_info const simd_checks[] =
+{
+    { simd_isa::sse2, "sse2", "-msse2" },
+    { simd_isa::avx2, "avx2", "-mavx2" },
+    { simd_isa::avx512, "avx512", "-mavx512f" },
+    { simd_isa::vector, "vector", "" },
+};
+
+static void write_simd_check(std::ostream &os, number_type type,
+                             real const &xmin, real const &xmax,
+                             code_generator const &kernel)
+{
+    std::string const t = get_target_info(type).name;
+    std::string const &f = kernel.name();
+
+    os << "// SIMD check generated by lolremez\n\n";
+    os << "#include <cstdio>\n#include <cstring>\n\n";
+    kernel.emit_scalar(os);
+
+    // One array function per instruction set, selected at build time
+    for (size_t i = 0; i < sizeof(simd_checks) / sizeof(*simd_checks); ++i)
+    {
+        os << '\n' << (i ? "#elif" : "#if") << " SIMD_CHECK == " << i << '\n';
+        kernel.emit_array(os, simd_checks[i].isa);
+    }
+    os << "#endif\n\n";
+
+    os << "static " << t << " const xmin = " << format_literal(xmin, type) << ";\n";
+    os << "static " << t << " const xmax = " << format_literal(xmax, type) << ";\n\n";
+
+    // Compare the outputs bit for bit, and check that nothing is written
+    // past the end
+    os << "static bool check(" << t << " const *in, " << t << " *out, size_t n)\n{\n"
+       << "    std::memset(out, 0xff, (n + 1) * sizeof(*out));\n"
+       << "    " << f << "_n(in, out, n);\n"
+       << "    for (size_t i = 0; i <= n; ++i)\n    {\n"
+       << "        " << t << " y;\n"
+       << "        if (i < n)\n"
+       << "            y = " << f << "(in[i]);\n"
+       << "        else\n"
+       << "            std::memset(&y, 0xff, sizeof(y));\n"
+       << "        if (std::memcmp(&y, out + i, sizeof(y)) != 0)\n        {\n"
+       << "            std::printf(\"mismatch %a\\n\", (double)in[i]);\n"
+       << "            return false;\n"
+       << "        }\n"
+       << "    }\n"
+       << "    return true;\n}\n\n";
+
+    // Every length up to 40 covers the remainder loop for all vector
+    // widths; odd offsets make the buffers unaligned.
+    os << "int main()\n{\n"
+       << "    size_t const size = 1024;\n"
+       << "    static " << t << " in[size + 2], out[size + 2];\n"
+       << "    for (size_t i = 0; i < size + 2; ++i)\n"
+       << "        in[i] = xmin + (xmax - xmin) * (" << t << ")i / (" << t << ")(size + 1);\n"
+       << "    for (size_t offset = 0; offset < 2; ++offset)\n    {\n"
+       << "        for (size_t n = 0; n <= 40; ++n)\n"
+       << "            if (!check(in + offset, out + offset, n))\n"
+       << "                return 0;\n"
+       << "        if (!check(in + offset, out + offset, size))\n"
+       << "            return 0;\n"
+       << "    }\n"
+       << "    std::printf(\"ok\\n\");\n"
+       << "    return 0;\n}\n";
+}
+
+bool check_simd(std::string const &path, number_type type,
+                real const &xmin, real const &xmax,
+                code_generator const &kernel,
+                std::vector<simd_check_result> &results, std::string &compiler)
+{
+    {
+        std::ofstream file(path);
+        if (!file)
+            return false;
+        write_simd_check(file, type, xmin, xmax, kernel);
+    }
+
+    // Without FMA contraction, in the scalar function especially, so that
+    // both sides round the same operations
+    std::string const exe = executable(path);
+    compiler = compiler_command() + " -ffp-contract=off";
+
+    for (size_t i = 0; i < sizeof(simd_checks) / sizeof(*simd_checks); ++i)
+    {
+        auto const &c = simd_checks[i];
+        results.push_back(simd_check_result { c.name, simd_check_result::status::failed, "" });
+        auto &r = results.back();
+
+        std::string const build = compiler + " " + c.flags + " -DSIMD_CHECK=" + std::to_string(i)
+                                + " -o \"" + exe + "\" \"" + path + "\"";
+        if (system(build.c_str()) != 0)
+            continue;
+
+        FILE *p = popen(("\"" + exe + "\"").c_str(), "r");
+        if (!p)
+            continue;
+
+        char line[256];
+        std::string word, x;
+        if (fgets(line, sizeof(line), p))
+            std::istringstream(line) >> word >> x;
+        int const status = pclose(p);
+
+#if !_WIN32
+        if (status != -1 && WIFSIGNALED(status) && WTERMSIG(status) == SIGILL)
+        {
+            r.status = simd_check_result::status::unsupported;
+            continue;
+        }
+#endif
+        if (status != 0)
+            continue;
+        if (word == "ok")
+            r.status = simd_check_result::status::match;
+        else if (word == "mismatch")
+            r.status = simd_check_result::status::mismatch, r.x = x;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// Microbenchmarks and checks for the generated code
+// -------------------------------------------------
+//
+// Writes a small C++ program that times the generated kernels, or that
+// compares the array function with the scalar one, builds it with the
+// system compiler ($CXX, or c++ by default, with $CXXFLAGS or -O2) and
+// runs it.
+//
+
+#include <lol/real>
+
+#include <string>
+#include <vector>
+
+#include "codegen.h"
+#include "target.h"
+
+struct bench_result
+{
+    std::string name;
+    // Nanoseconds per call when each call depends on the previous one,
+    // and when calls are independent (array processing)
+    double latency, throughput;
+};
+
+// Write the benchmark to “path”, then try to build and run it. Returns
+// false if the program could not be built or run; “compiler” receives
+// the command line used.
+bool run_benchmark(std::string const &path, number_type type,
+                   lol::real const &xmin, lol::real const &xmax,
+                   std::vector<code_generator> const &kernels,
+                   std::vector<bench_result> &results, std::string &compiler);
+
+struct simd_check_result
+{
+    std::string name;
+    enum class status
+    {
+        match,
+        mismatch,
+        unsupported, // the CPU lacks the instruction set
+        failed,      // the program could not be built or run
+    } status;
+    // First input where the outputs differ
+    std::string x;
+};
+
+// Write a program comparing the array function of “kernel” with its
+// scalar function to “path”, then build and run it once per SIMD
+// instruction set. All outputs of the vector loop and of the remainder
+// loop must match bit for bit, for every length up to 40 and with
+// unaligned buffers. Returns false if the program could not be written.
+bool check_simd(std::string const &path, number_type type,
+                lol::real const &xmin, lol::real const &xmax,
+                code_generator const &kernel,
+                std::vector<simd_check_result> &results, std::string &compiler);
@@ -0,0 +1,133 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+#include <utility>   // std::swap
+
+#include <lol/real>
+
+#include "chebyshev.h"
+
+using lol::real;
+
+chebyshev_form::chebyshev_form(std::vector<real> const &coeffs, real const &k1,
+                               real const &k2, number_type type)
+  : m_k1(round_to(k1, get_target_info(type).compute)),
+    m_inv_k2(round_to(real::R_1() / k2, get_target_info(type).compute)),
+    m_type(type)
+{
+    // Coefficients are stored in the target type, the offset and the scale
+    // in its arithmetic type
+    for (auto const &a : coeffs)
+        m_coeffs.push_back(round_to(a, type));
+}
+
+// The same operations, in the same order, as the emitted code
+template<typename T>
+T chebyshev_form::eval(T x) const
+{
+    int const n = int(m_coeffs.size()) - 1;
+    T const t = (x - T(m_k1)) * T(m_inv_k2);
+    T const t2 = t + t;
+
+    if (n == 0)
+        return T(m_coeffs[0]);
+
+    T u = T(m_coeffs[n]), v = 0;
+    if (n >= 2)
+    {
+        v = t2 * u + T(m_coeffs[n - 1]);
+        for (int k = n - 2; k >= 1; --k)
+        {
+            u = t2 * v - u + T(m_coeffs[k]);
+            std::swap(u, v);
+        }
+        std::swap(u, v);
+    }
+
+    // Here u holds b_1 and v holds b_2
+    return t * u - v + T(m_coeffs[0]);
+}
+
+real chebyshev_form::eval(real const &x) const
+{
+    auto const &info = get_target_info(m_type);
+    real y;
+    switch (info.compute)
+    {
+    case number_type::float32: y = real(eval(float(x))); break;
+    case number_type::float64: y = real(eval(double(x))); break;
+    case number_type::long_double:
+    default: y = real(eval((long double)x)); break;
+    }
+    return info.compute == m_type ? y : round_to(y, m_type);
+}
+
+double chebyshev_form::observed_error(expression const &func, real const &xmin,
+                                      real const &xmax, int samples) const
+{
+    double ret = 0;
+    for (int i = 0; i < samples; ++i)
+    {
+        real const x = round_to(xmin + (xmax - xmin) * real(i) / real(samples - 1), m_type);
+        real const fx = func.eval(x);
+        ret = std::max(ret, double(fabs(eval(x) - fx) / ulp(fx, m_type)));
+    }
+    return ret;
+}
+
+void chebyshev_form::emit(std::ostream &os, std::string const &name, bool hex) const
+{
+    auto const &info = get_target_info(m_type);
+    char const *type = info.name;
+    char const *ctype = get_target_info(info.compute).name;
+    int const n = int(m_coeffs.size()) - 1;
+    auto a = [&](int k) { return format_literal(m_coeffs[k], m_type, hex); };
+
+    if (info.compute == m_type)
+        os << type << ' ' << name << '(' << type << " x)\n{\n";
+    else
+        os << type << ' ' << name << '(' << type << " in)\n{\n"
+           << "    " << ctype << " x = in;\n";
+    os << "    " << ctype << " const t = (x - " << format_literal(m_k1, info.compute, hex)
+       << ") * " << format_literal(m_inv_k2, info.compute, hex) << ";\n";
+
+    // Clenshaw’s recurrence, alternating between two variables so that
+    // the older one gets overwritten with the new value
+    std::string ret;
+    if (n == 0)
+        ret = a(0);
+    else if (n == 1)
+        ret = "t * " + a(1) + " + " + a(0);
+    else
+    {
+        std::string u = "u", v = "v";
+        os << "    " << ctype << " const t2 = t + t;\n";
+        os << "    " << ctype << " u = " << a(n) << ";\n";
+        os << "    " << ctype << " v = t2 * u + " << a(n - 1) << ";\n";
+        for (int k = n - 2; k >= 1; --k)
+        {
+            os << "    " << u << " = t2 * " << v << " - " << u << " + " << a(k) << ";\n";
+            std::swap(u, v);
+        }
+        ret = "t * " + v + " - " + u + " + " + a(0);
+    }
+
+    if (info.compute == m_type)
+        os << "    return " << ret << ";\n}\n";
+    else
+        os << "    return (" << type << ")(" << ret << ");\n}\n";
+}
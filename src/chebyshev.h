@@ -0,0 +1,58 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The chebyshev_form class
+// ------------------------
+//
+// A polynomial stored as Σ a_k·T_k(t) on the scaled variable
+// t = (x - k1) / k2, evaluated with Clenshaw’s recurrence
+//   b_k = a_k + 2t·b_(k+1) - b_(k+2),   p = a_0 + t·b_1 - b_2
+// The coefficients stay bounded by the function’s own magnitude, unlike
+// monomial coefficients which blow up with the degree or when the range
+// is far from zero.
+//
+
+#include <lol/real>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+#include "target.h"
+
+class chebyshev_form
+{
+public:
+    chebyshev_form(std::vector<lol::real> const &coeffs, lol::real const &k1,
+                   lol::real const &k2, number_type type);
+
+    // Evaluate exactly as the generated code does
+    lol::real eval(lol::real const &x) const;
+
+    // Largest error of the generated code against func, in ulps, on
+    // evenly spaced samples
+    double observed_error(expression const &func, lol::real const &xmin,
+                          lol::real const &xmax, int samples = 2048) const;
+
+    void emit(std::ostream &os, std::string const &name, bool hex) const;
+
+private:
+    template<typename T> T eval(T x) const;
+
+    std::vector<lol::real> m_coeffs;
+    lol::real m_k1, m_inv_k2;
+    number_type m_type;
+};
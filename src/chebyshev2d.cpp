@@ -0,0 +1,236 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+#include <functional>
+#include <utility>   // std::swap
+
+#include <lol/math>
+#include <lol/real>
+
+#include "chebyshev2d.h"
+
+using lol::real;
+
+/* Kinds of worker jobs: sampling grid row j is job j of sample_job,
+ * transforming row j is job j of row_job, transforming column i is job i
+ * of column_job, and checking row j of the check grid is job j of
+ * check_job. */
+static int const sample_job = 1;
+static int const row_job = 2;
+static int const column_job = 3;
+static int const check_job = 4;
+
+// Sample count for a given degree: a power of two, so that the transform
+// can use a radix-2 FFT, and at least twice the degree, so that the
+// truncated coefficients are accurate.
+static int grid_size(int degree)
+{
+    int n = 2;
+    while (n < 2 * degree)
+        n *= 2;
+    return n;
+}
+
+chebyshev2d::chebyshev2d(function const &f, real const &xmin, real const &xmax,
+                         real const &ymin, real const &ymax,
+                         int degree_x, int degree_y)
+  : m_func(f),
+    m_degree_x(degree_x),
+    m_degree_y(degree_y),
+    m_nx(grid_size(degree_x)),
+    m_ny(grid_size(degree_y)),
+    m_xmin(xmin),
+    m_xmax(xmax),
+    m_ymin(ymin),
+    m_ymax(ymax),
+    m_coeffs(m_nx + 1, m_ny + 1),
+    m_pool([this](int i) { return do_job(i); })
+{
+    int const m = 2 * std::max(m_nx, m_ny);
+    for (int k = 0; k < m / 2; ++k)
+    {
+        m_cos.push_back(cos(real::R_PI() * (2 * k) / m));
+        m_sin.push_back(sin(real::R_PI() * (2 * k) / m));
+    }
+
+    /* Sample, then transform along x and along y */
+    m_pool.run(sample_job, m_ny + 1);
+    m_pool.run(row_job, m_ny + 1);
+    m_pool.run(column_job, m_nx + 1);
+}
+
+void chebyshev2d::truncate(int total_degree)
+{
+    for (int j = 0; j <= m_ny; ++j)
+        for (int i = 0; i <= m_nx; ++i)
+            if (i > m_degree_x || j > m_degree_y || (total_degree >= 0 && i + j > total_degree))
+                m_coeffs[j][i] = real::R_0();
+}
+
+real chebyshev2d::eval(real const &x, real const &y) const
+{
+    real const s = (x + x - m_xmin - m_xmax) / (m_xmax - m_xmin);
+    real const t = (y + y - m_ymin - m_ymax) / (m_ymax - m_ymin);
+
+    // T_i(s) and T_j(t) from the three-term recurrence
+    std::vector<real> ts(m_degree_x + 1), tt(m_degree_y + 1);
+    ts[0] = tt[0] = real::R_1();
+    for (int i = 1; i <= m_degree_x; ++i)
+        ts[i] = i == 1 ? s : 2 * s * ts[i - 1] - ts[i - 2];
+    for (int j = 1; j <= m_degree_y; ++j)
+        tt[j] = j == 1 ? t : 2 * t * tt[j - 1] - tt[j - 2];
+
+    real ret(0);
+    for (int j = 0; j <= m_degree_y; ++j)
+    {
+        real row(0);
+        for (int i = 0; i <= m_degree_x; ++i)
+            row += m_coeffs[j][i] * ts[i];
+        ret += row * tt[j];
+    }
+    return ret;
+}
+
+real chebyshev2d::check_error(int samples)
+{
+    m_check_samples = samples;
+    m_row_error.resize(samples + 1);
+    m_pool.run(check_job, samples + 1);
+
+    real ret(0);
+    for (auto const &e : m_row_error)
+        ret = max(ret, e);
+    return ret;
+}
+
+// Rewrite Σ c_ij·T_i(s)·T_j(t) as Σ_j P_j(x)·y^j
+std::vector<lol::polynomial<real>> chebyshev2d::get_estimate() const
+{
+    lol::polynomial<real> const sx({ -(m_xmin + m_xmax) / (m_xmax - m_xmin),
+                                     real(2) / (m_xmax - m_xmin) });
+    lol::polynomial<real> const ty({ -(m_ymin + m_ymax) / (m_ymax - m_ymin),
+                                     real(2) / (m_ymax - m_ymin) });
+
+    std::vector<lol::polynomial<real>> tx;
+    for (int i = 0; i <= m_degree_x; ++i)
+        tx.push_back(lol::polynomial<real>::chebyshev(i).eval(sx));
+
+    std::vector<lol::polynomial<real>> ret(m_degree_y + 1);
+    for (int j = 0; j <= m_degree_y; ++j)
+    {
+        lol::polynomial<real> pj;
+        for (int i = 0; i <= m_degree_x; ++i)
+            if (!m_coeffs[j][i].is_zero())
+                pj += tx[i] * m_coeffs[j][i];
+
+        auto const tj = lol::polynomial<real>::chebyshev(j).eval(ty);
+        for (int l = 0; l <= tj.degree(); ++l)
+            ret[l] += pj * tj[l];
+    }
+    return ret;
+}
+
+// Chebyshev coefficients of the interpolant through v_k = g(cos(πk/N)),
+// k = 0…N, in place. This is a type-I DCT, computed as the FFT of the
+// even extension of v, of length 2N:
+//   c_j = (2/N)·Σ″ v_k·cos(πjk/N)
+// where Σ″ halves the first and last terms, and c_0 and c_N are halved.
+void chebyshev2d::dct(std::vector<real> &v) const
+{
+    int const n = int(v.size()) - 1, len = 2 * n;
+    int const stride = 2 * int(m_cos.size()) / len;
+
+    std::vector<real> re(len), im(len);
+    for (int k = 0; k < len; ++k)
+        re[k] = v[k <= n ? k : len - k];
+
+    // Iterative radix-2 FFT, with bit-reversed input
+    for (int i = 1, j = 0; i < len; ++i)
+    {
+        int bit = len >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(re[i], re[j]);
+    }
+
+    for (int size = 2; size <= len; size *= 2)
+    {
+        int const half = size / 2, step = stride * (len / size);
+        for (int start = 0; start < len; start += size)
+            for (int k = 0; k < half; ++k)
+            {
+                real const &c = m_cos[k * step], &s = m_sin[k * step];
+                int const a = start + k, b = a + half;
+                real const bre = re[b] * c + im[b] * s;
+                real const bim = im[b] * c - re[b] * s;
+                re[b] = re[a] - bre;
+                im[b] = im[a] - bim;
+                re[a] += bre;
+                im[a] += bim;
+            }
+    }
+
+    // The transform of the even extension is 2·Σ″
+    for (int j = 0; j <= n; ++j)
+        v[j] = re[j] / real(j == 0 || j == n ? 2 * n : n);
+}
+
+int chebyshev2d::do_job(int i)
+{
+    int const kind = worker_pool::job_kind(i), k = worker_pool::job_index(i);
+
+    if (kind == check_job)
+    {
+        real const y = m_ymin + (m_ymax - m_ymin) * real(k) / real(m_check_samples);
+        real err(0);
+        for (int n = 0; n <= m_check_samples; ++n)
+        {
+            real const x = m_xmin + (m_xmax - m_xmin) * real(n) / real(m_check_samples);
+            err = max(err, fabs(m_func(x, y) - eval(x, y)));
+        }
+        m_row_error[k] = err;
+    }
+    else if (kind == column_job)
+    {
+        std::vector<real> v(m_ny + 1);
+        for (int j = 0; j <= m_ny; ++j)
+            v[j] = m_coeffs[j][k];
+        dct(v);
+        for (int j = 0; j <= m_ny; ++j)
+            m_coeffs[j][k] = v[j];
+    }
+    else if (kind == row_job)
+    {
+        std::vector<real> v(m_coeffs[k], m_coeffs[k] + m_nx + 1);
+        dct(v);
+        std::copy(v.begin(), v.end(), m_coeffs[k]);
+    }
+    else if (kind == sample_job)
+    {
+        // Chebyshev extrema, in the order cos(πk/N) expected by dct()
+        real const y = (m_ymin + m_ymax + (m_ymax - m_ymin) * cos(real::R_PI() * k / m_ny)) / 2;
+        for (int n = 0; n <= m_nx; ++n)
+        {
+            real const x = (m_xmin + m_xmax + (m_xmax - m_xmin) * cos(real::R_PI() * n / m_nx)) / 2;
+            m_coeffs[k][n] = m_func(x, y);
+        }
+    }
+
+    return i;
+}
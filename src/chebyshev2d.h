@@ -0,0 +1,80 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The chebyshev2d class
+// ---------------------
+//
+// Tensor-product Chebyshev interpolation: f is sampled on a grid of
+// Chebyshev extrema, and the coefficients of Σ c_ij·T_i(s)·T_j(t) are
+// obtained with a type-I discrete cosine transform along each direction,
+// computed by FFT. Truncating the coefficients then gives a polynomial
+// that is usually close to the minimax one, at a fraction of the cost.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <functional>
+#include <vector>
+
+#include "matrix.h"
+#include "pool.h"
+
+class chebyshev2d
+{
+public:
+    typedef std::function<lol::real(lol::real const &, lol::real const &)> function;
+
+    // Interpolate f on a grid fine enough for polynomials of the given
+    // degrees in x and y; f must be safe to call from several threads
+    chebyshev2d(function const &f, lol::real const &xmin, lol::real const &xmax,
+                lol::real const &ymin, lol::real const &ymax,
+                int degree_x, int degree_y);
+
+    // Drop the coefficients of degree higher than the requested ones, and
+    // optionally those of total degree above total_degree
+    void truncate(int total_degree = -1);
+
+    lol::real eval(lol::real const &x, lol::real const &y) const;
+
+    // Largest error on an evenly spaced (samples + 1)² grid
+    lol::real check_error(int samples);
+
+    // The polynomial as Σ_j p[j](x)·y^j
+    std::vector<lol::polynomial<lol::real>> get_estimate() const;
+
+private:
+    void dct(std::vector<lol::real> &v) const;
+    int do_job(int i);
+
+    function m_func;
+    int m_degree_x, m_degree_y;
+    int m_nx, m_ny;
+    lol::real m_xmin, m_xmax, m_ymin, m_ymax;
+
+    // Samples f(x_i,y_j) at [j][i], transformed in place into c_ij
+    array2d<lol::real> m_coeffs;
+
+    // FFT twiddle factors cos(2πk/M) and sin(2πk/M) for the largest
+    // transform size M; smaller sizes use every other one, etc.
+    std::vector<lol::real> m_cos, m_sin;
+
+    // Check grid size and results, one per row
+    int m_check_samples = 0;
+    std::vector<lol::real> m_row_error;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
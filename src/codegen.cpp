@@ -0,0 +1,285 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+#include <iomanip>
+#include <iostream>
+
+#include <lol/real>
+#include <lol/math>
+
+#include "codegen.h"
+
+using lol::real;
+
+code_generator::code_generator(lol::polynomial<real> const &p, number_type type,
+                               eval_scheme const &scheme)
+  : m_poly(p),
+    m_type(type),
+    m_scheme(scheme)
+{
+}
+
+std::string code_generator::literal(int j) const
+{
+    return format_literal(m_poly[j], m_type, m_hex);
+}
+
+std::string code_generator::operand(eval_scheme::operand const &o, syntax const &s) const
+{
+    switch (o.kind)
+    {
+    case eval_scheme::operand::x:
+        return "x";
+    case eval_scheme::operand::coeff:
+        return s.coeffs == syntax::literal ? literal(o.index)
+             : s.coeffs == syntax::named ? "c" + std::to_string(o.index)
+             : "T(" + m_name + "_coeffs[" + std::to_string(o.index) + "])";
+    case eval_scheme::operand::var:
+    default:
+        return m_scheme.vars()[o.index];
+    }
+}
+
+std::string code_generator::expr(eval_scheme::op const &o, syntax const &s) const
+{
+    auto a = operand(o.a, s), b = operand(o.b, s), c = operand(o.c, s);
+    auto mul = s.prefix.empty() ? a + " * " + b
+                                : s.prefix + "_mul" + s.suffix + "(" + a + ", " + b + ")";
+
+    switch (o.kind)
+    {
+    case eval_scheme::op::set:
+        return a;
+    case eval_scheme::op::mul:
+        return mul;
+    case eval_scheme::op::add:
+        return s.prefix.empty() ? a + " + " + b
+                                : s.prefix + "_add" + s.suffix + "(" + a + ", " + b + ")";
+    case eval_scheme::op::muladd:
+    default:
+        return s.prefix.empty() ? mul + " + " + c
+                                : s.prefix + "_add" + s.suffix + "(" + mul + ", " + c + ")";
+    }
+}
+
+void code_generator::emit_ops(std::ostream &os, std::string const &indent,
+                              std::string const &type, syntax const &s, bool ret) const
+{
+    auto const &ops = m_scheme.ops();
+    std::vector<bool> declared(m_scheme.vars().size(), false);
+    auto const result = m_scheme.result();
+
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        auto const &o = ops[i];
+        os << indent;
+        if (ret && i + 1 == ops.size() && result.kind == eval_scheme::operand::var
+             && result.index == o.dst)
+        {
+            os << "return " << expr(o, s) << ";\n";
+            return;
+        }
+
+        if (!declared[o.dst])
+            os << type << ' ';
+        declared[o.dst] = true;
+        os << m_scheme.vars()[o.dst] << " = " << expr(o, s) << ";\n";
+    }
+
+    if (ret)
+        os << indent << "return " << operand(result, s) << ";\n";
+}
+
+void code_generator::emit_scalar(std::ostream &os) const
+{
+    auto const &info = get_target_info(m_type);
+    char const *type = info.name;
+    syntax const s { syntax::literal, "", "" };
+
+    if (info.compute == m_type)
+    {
+        os << type << ' ' << m_name << '(' << type << " x)\n{\n";
+        emit_ops(os, "    ", type, s, true);
+    }
+    else
+    {
+        // Storage-only type: evaluate in the arithmetic type, and convert
+        // back explicitly since C++23 forbids implicit narrowing there.
+        char const *ctype = get_target_info(info.compute).name;
+        os << type << ' ' << m_name << '(' << type << " in)\n{\n";
+        os << "    " << ctype << " x = in;\n";
+        emit_ops(os, "    ", ctype, s, false);
+        os << "    return (" << type << ')' << operand(m_scheme.result(), s) << ";\n";
+    }
+    os << "}\n";
+}
+
+void code_generator::emit_array(std::ostream &os, simd_isa isa) const
+{
+    // Intrinsics naming: prefix, vector type and lane count, for float and
+    // double respectively.
+    struct isa_info
+    {
+        char const *header, *prefix;
+        char const *vtype[2];
+        int lanes[2];
+    };
+
+    static isa_info const info[] =
+    {
+        { "emmintrin.h", "_mm", { "__m128", "__m128d" }, { 4, 2 } },
+        { "immintrin.h", "_mm256", { "__m256", "__m256d" }, { 8, 4 } },
+        { "immintrin.h", "_mm512", { "__m512", "__m512d" }, { 16, 8 } },
+    };
+
+    char const *type = get_target_info(m_type).name;
+    int const n = m_scheme.degree();
+    int const dbl = m_type == number_type::float64 ? 1 : 0;
+
+    // The compiler may fuse the multiplies and adds of the scalar function,
+    // or of vector extension code, into FMAs, which round differently
+    std::string const fma_note =
+        "// Results match those of " + m_name + "() bit for bit only if this code is\n"
+        "// built with -ffp-contract=off.\n";
+
+    if (isa == simd_isa::vector)
+    {
+        // Generic vector extensions: let the compiler pick the instructions;
+        // 32-byte vectors map to AVX registers or pairs of SSE registers.
+        std::string const vtype = m_name + "_vec";
+
+        os << "#include <stddef.h>\n#include <string.h>\n\n";
+        os << fma_note;
+        os << "typedef " << type << ' ' << vtype << " __attribute__((vector_size(32)));\n\n";
+        os << (m_inline ? "inline " : "") << "void " << m_name << "_n("
+           << type << " const *in, " << type << " *out, size_t n)\n{\n";
+        os << "    " << vtype << " const zero = { 0 };\n";
+        for (int j = n; j >= 0; --j)
+            os << "    " << vtype << " const c" << j << " = zero + " << literal(j) << ";\n";
+        os << "    size_t const lanes = sizeof(" << vtype << ") / sizeof(" << type << ");\n";
+        os << "    size_t i = 0;\n";
+        os << "    for (; i + lanes <= n; i += lanes)\n    {\n";
+        os << "        " << vtype << " x;\n";
+        os << "        memcpy(&x, in + i, sizeof(x));\n";
+        emit_ops(os, "        ", vtype, syntax { syntax::named, "", "" }, false);
+        os << "        memcpy(out + i, &" << operand(m_scheme.result(), syntax { syntax::named, "", "" })
+           << ", sizeof(x));\n";
+        os << "    }\n";
+    }
+    else
+    {
+        auto const &isa_data = info[int(isa) - int(simd_isa::sse2)];
+        syntax const s { syntax::named, isa_data.prefix, dbl ? "_pd" : "_ps" };
+        char const *vtype = isa_data.vtype[dbl];
+        int const lanes = isa_data.lanes[dbl];
+
+        // Keep all coefficients in registers across iterations, and use
+        // separate mul/add so that results match the scalar function bit
+        // for bit.
+        os << "#include <" << isa_data.header << ">\n#include <stddef.h>\n\n";
+        os << fma_note;
+        os << (m_inline ? "inline " : "") << "void " << m_name << "_n("
+           << type << " const *in, " << type << " *out, size_t n)\n{\n";
+        for (int j = n; j >= 0; --j)
+            os << "    " << vtype << " const c" << j << " = "
+               << s.prefix << "_set1" << s.suffix << '(' << literal(j) << ");\n";
+        os << "    size_t i = 0;\n";
+        os << "    for (; i + " << lanes << " <= n; i += " << lanes << ")\n    {\n";
+        os << "        " << vtype << " const x = " << s.prefix << "_loadu" << s.suffix << "(in + i);\n";
+        emit_ops(os, "        ", vtype, s, false);
+        os << "        " << s.prefix << "_storeu" << s.suffix << "(out + i, "
+           << operand(m_scheme.result(), s) << ");\n";
+        os << "    }\n";
+    }
+
+    // Remainder loop
+    os << "    for (; i < n; ++i)\n";
+    os << "        out[i] = " << m_name << "(in[i]);\n";
+    os << "}\n";
+}
+
+void code_generator::emit_header(std::ostream &os, lol::real const &max_error, double max_ulp,
+                                 std::vector<header_check> const &checks) const
+{
+    char const *type = get_target_info(m_type).name;
+    int const n = m_scheme.degree();
+
+    os << "#pragma once\n\n";
+
+    // Metadata and coefficients, in increasing degree order
+    os << "inline constexpr int " << m_name << "_degree = " << n << ";\n";
+    os << std::setprecision(3);
+    os << "inline constexpr double " << m_name << "_max_error = " << double(max_error) << ";\n";
+    os << "inline constexpr double " << m_name << "_max_ulp = " << max_ulp << ";\n";
+    os << "inline constexpr " << type << ' ' << m_name << "_coeffs[] =\n{\n";
+    for (int j = 0; j <= n; ++j)
+        os << "    " << literal(j) << ",\n";
+    os << "};\n\n";
+
+    os << "static_assert(sizeof(" << m_name << "_coeffs) / sizeof(*" << m_name << "_coeffs) == "
+       << m_name << "_degree + 1,\n              \"unexpected coefficient count\");\n";
+    os << "static_assert(" << m_name << "_max_error >= 0 && " << m_name << "_max_ulp >= 0,\n"
+       << "              \"invalid error metadata\");\n\n";
+
+    // Fully unrolled evaluation, usable in constant expressions
+    os << "template<typename T>\nconstexpr T " << m_name << "(T x)\n{\n";
+    emit_ops(os, "    ", "T", syntax { syntax::table, "", "" }, true);
+    os << "}\n";
+
+    // Check the evaluation against the reference function at compile time,
+    // within the total error budget.
+    if (checks.size())
+        os << '\n';
+    for (auto const &c : checks)
+    {
+        auto const x = format_literal(c.x, m_type, m_hex);
+        auto const value = format_literal(c.value, m_type, m_hex);
+        auto const tolerance = format_literal(c.tolerance, m_type, m_hex);
+        auto const call = m_name + "<" + type + ">(" + x + ")";
+        os << "static_assert(" << call << " - " << value << " <= " << tolerance << " &&\n"
+           << "              " << value << " - " << call << " <= " << tolerance << ",\n"
+           << "              \"error budget exceeded at x = " << x << "\");\n";
+    }
+}
+
+void emit_horner2d(std::ostream &os, std::vector<lol::polynomial<real>> const &p,
+                   number_type type, std::string const &name, bool hex)
+{
+    char const *t = get_target_info(type).name;
+    int const n = int(p.size()) - 1;
+    auto a = [&](int i, int j) { return format_literal(p[j][i], type, hex); };
+
+    // Each coefficient polynomial is evaluated into v, then accumulated
+    // into u; leading zero coefficients are skipped
+    auto horner_x = [&](int j, char const *dest)
+    {
+        int const d = std::max(p[j].degree(), 0);
+        os << "    " << dest << " = " << a(d, j) << ";\n";
+        for (int i = d - 1; i >= 0; --i)
+            os << "    " << dest << " = " << dest << " * x + " << a(i, j) << ";\n";
+    };
+
+    os << t << ' ' << name << '(' << t << " x, " << t << " y)\n{\n";
+    os << "    " << t << " u, v;\n";
+    horner_x(n, "u");
+    for (int j = n - 1; j >= 0; --j)
+    {
+        horner_x(j, "v");
+        os << "    u = u * y + v;\n";
+    }
+    os << "    return u;\n}\n";
+}
@@ -0,0 +1,107 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The code_generator class
+// ------------------------
+//
+// Prints C/C++ code evaluating a polynomial in a given target type, using
+// a given evaluation scheme.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "scheme.h"
+#include "target.h"
+
+enum class simd_isa
+{
+    none,
+    sse2,
+    avx2,
+    avx512,
+    vector, // GCC/Clang vector extensions
+};
+
+// A compile-time check for the generated header: |f(x) - value| must be
+// at most “tolerance”.
+struct header_check
+{
+    lol::real x, value, tolerance;
+};
+
+class code_generator
+{
+public:
+    code_generator(lol::polynomial<lol::real> const &p, number_type type,
+                   eval_scheme const &scheme);
+
+    void set_name(std::string const &name) { m_name = name; }
+    std::string const &name() const { return m_name; }
+    eval_scheme const &scheme() const { return m_scheme; }
+
+    void set_hex(bool hex) { m_hex = hex; }
+    // Mark non-template functions inline, e.g. when emitting a header
+    void set_inline(bool inl) { m_inline = inl; }
+
+    // Scalar function: type f(type x)
+    void emit_scalar(std::ostream &os) const;
+
+    // Array function: void f_n(type const *in, type *out, size_t n), built
+    // on top of the scalar function for the remainder loop.
+    void emit_array(std::ostream &os, simd_isa isa) const;
+
+    // Self-contained C++17 header: constexpr coefficient table and error
+    // metadata, a constexpr function template parameterised on the scalar
+    // type, and static_assert checks of all of the above.
+    void emit_header(std::ostream &os, lol::real const &max_error, double max_ulp,
+                     std::vector<header_check> const &checks) const;
+
+private:
+    // How operations are spelt: infix C operators, or intrinsics with the
+    // given prefix and suffix, e.g. _mm256_add_pd(). Coefficients are either
+    // literals, named variables c0, c1…, or entries of the f_coeffs table.
+    struct syntax
+    {
+        enum { literal, named, table } coeffs;
+        std::string prefix, suffix;
+    };
+
+    std::string literal(int j) const;
+    std::string operand(eval_scheme::operand const &o, syntax const &s) const;
+    std::string expr(eval_scheme::op const &o, syntax const &s) const;
+
+    // Print all operations of the scheme; if “ret” is set, the final value
+    // is returned, otherwise it is left in the result operand.
+    void emit_ops(std::ostream &os, std::string const &indent,
+                  std::string const &type, syntax const &s, bool ret) const;
+
+    lol::polynomial<lol::real> m_poly;
+    number_type m_type;
+    eval_scheme m_scheme;
+    std::string m_name = "f";
+    bool m_hex = false;
+    bool m_inline = false;
+};
+
+// Bivariate polynomial Σ_j p[j](x)·y^j, as a polynomial in y whose
+// coefficients are polynomials in x, both evaluated with Horner’s scheme:
+// type name(type x, type y)
+void emit_horner2d(std::ostream &os, std::vector<lol::polynomial<lol::real>> const &p,
+                   number_type type, std::string const &name, bool hex);
@@ -0,0 +1,281 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <functional>
+
+#include <lol/real>
+
+#include "cross.h"
+
+using lol::real;
+
+/* Kinds of worker jobs: scanning grid row y is job y of scan_job,
+ * sampling it is job y of sample_job, and checking midpoint row j is job
+ * j of check_job. */
+static int const scan_job = 0;
+static int const sample_job = 1;
+static int const check_job = 2;
+
+cross_solver::cross_solver(function const &f, real const &xmin, real const &xmax,
+                           real const &ymin, real const &ymax,
+                           int grid_size, int max_rank)
+  : m_func(f),
+    m_grid_size(grid_size),
+    m_max_rank(max_rank),
+    m_residual(grid_size + 1, grid_size + 1),
+    m_core(max_rank, max_rank),
+    m_lower(max_rank, max_rank),
+    m_upper(max_rank, max_rank),
+    m_pool([this](int i) { return do_job(i); })
+{
+    // Chebyshev extrema for sampling, and the midpoints between them
+    auto cheb = [](real const &a, real const &b, int i, int n)
+    {
+        return a + (b - a) * (real::R_1() - cos(real::R_PI() * i / n)) / 2;
+    };
+
+    for (int i = 0; i <= grid_size; ++i)
+    {
+        m_xs.push_back(cheb(xmin, xmax, i, grid_size));
+        m_ys.push_back(cheb(ymin, ymax, i, grid_size));
+    }
+
+    for (int i = 0; i < grid_size; ++i)
+    {
+        m_check_xs.push_back(cheb(xmin, xmax, 2 * i + 1, 2 * grid_size));
+        m_check_ys.push_back(cheb(ymin, ymax, 2 * i + 1, 2 * grid_size));
+    }
+
+    m_row_best.resize(grid_size + 1);
+    m_row_error.resize(grid_size);
+
+    /* Sample f on the whole grid, then look for the first pivot */
+    m_pool.run(sample_job, grid_size + 1);
+    m_pool.run(scan_job, grid_size + 1);
+    reduce();
+}
+
+void cross_solver::step()
+{
+    assert(rank() < m_max_rank && !m_best.val.is_zero());
+
+    /* Prepare e_k(x,y) = e_{k-1}(x,y) - e_{k-1}(x,y_k)·e_{k-1}(x_k,y)/d_k
+     * with d_k = e_{k-1}(x_k,y_k); the workers apply it during the scan */
+    index2 const pivot = m_best.pivot;
+    real const inv_d = real::R_1() / m_best.val;
+
+    m_update_col.resize(m_grid_size + 1);
+    m_update_row.resize(m_grid_size + 1);
+    for (int i = 0; i <= m_grid_size; ++i)
+    {
+        m_update_col[i] = m_residual[i][pivot.x] * inv_d;
+        m_update_row[i] = m_residual[pivot.y][i];
+    }
+
+    /* Register new pivot */
+    update_core(pivot.x, pivot.y);
+    m_inv_d.push_back(inv_d);
+    m_pivots.push_back(pivot);
+
+    /* Apply the update and find a new good pivot */
+    m_pool.run(scan_job, m_grid_size + 1);
+    reduce();
+}
+
+real cross_solver::check_error()
+{
+    m_check = nullptr;
+    m_pool.run(check_job, m_grid_size);
+
+    real ret(0);
+    for (auto const &e : m_row_error)
+        ret = max(ret, e);
+    return ret;
+}
+
+real cross_solver::check_error(function const &approx)
+{
+    m_check = &approx;
+    m_pool.run(check_job, m_grid_size);
+    m_check = nullptr;
+
+    real ret(0);
+    for (auto const &e : m_row_error)
+        ret = max(ret, e);
+    return ret;
+}
+
+// g_k(x) = d_k·e_{k-1}(x,y_k) = d_k·Σ_a l_ka·f(x,y_a)
+real cross_solver::eval_g(int k, real const &x) const
+{
+    real ret(0);
+    for (int a = 0; a <= k; ++a)
+        ret += m_lower[k][a] * m_func(x, m_ys[m_pivots[a].y]);
+    return ret * m_inv_d[k];
+}
+
+// h_k(y) = e_{k-1}(x_k,y) = Σ_b u_kb·f(x_b,y)
+real cross_solver::eval_h(int k, real const &y) const
+{
+    real ret(0);
+    for (int b = 0; b <= k; ++b)
+        ret += m_upper[k][b] * m_func(m_xs[m_pivots[b].x], y);
+    return ret;
+}
+
+// The y-dependent part of the approximation is a k×k matrix-vector
+// product done once, after which each point costs O(k).
+void cross_solver::eval_ek_line(real const &y, std::vector<real> const &xs,
+                                std::vector<real> &ret) const
+{
+    int const k = rank();
+
+    /* c_a(y) = Σ_b w_ab·f(x_b,y) */
+    std::vector<real> fy(k), c(k);
+    for (int b = 0; b < k; ++b)
+        fy[b] = m_func(m_xs[m_pivots[b].x], y);
+    for (int a = 0; a < k; ++a)
+        for (int b = 0; b < k; ++b)
+            c[a] += m_core[a][b] * fy[b];
+
+    /* e_k(x,y) = f(x,y) - Σ_a f(x,y_a)·c_a(y) */
+    ret.resize(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+        ret[i] = m_func(xs[i], y);
+        for (int a = 0; a < k; ++a)
+            ret[i] -= m_func(xs[i], m_ys[m_pivots[a].y]) * c[a];
+    }
+}
+
+// Add pivot (x,y) with d = e_{k-1}(x,y) to the core inverse W. Bordering
+// the matrix of f at the pivots with the new row and column, W becomes
+//   | W + Wu·vW/d   -Wu/d |
+//   |   -vW/d        1/d  |
+// with u_b = f(x_b,y) and v_a = f(x,y_a); d is the Schur complement. Also,
+// -Wu and -vW are the coefficients of the new factors g_k and h_k.
+void cross_solver::update_core(int x, int y)
+{
+    int const k = rank();
+    real const &px = m_xs[x], &py = m_ys[y];
+
+    std::vector<real> u(k), v(k), wu(k), vw(k);
+    for (int n = 0; n < k; ++n)
+    {
+        u[n] = m_func(m_xs[m_pivots[n].x], py);
+        v[n] = m_func(px, m_ys[m_pivots[n].y]);
+    }
+    for (int a = 0; a < k; ++a)
+        for (int b = 0; b < k; ++b)
+        {
+            wu[a] += m_core[a][b] * u[b];
+            vw[b] += v[a] * m_core[a][b];
+        }
+
+    real const inv_d = real::R_1() / m_best.val;
+    for (int a = 0; a < k; ++a)
+    {
+        for (int b = 0; b < k; ++b)
+            m_core[a][b] += wu[a] * vw[b] * inv_d;
+        m_core[a][k] = -wu[a] * inv_d;
+        m_core[k][a] = -vw[a] * inv_d;
+        m_lower[k][a] = -wu[a];
+        m_upper[k][a] = -vw[a];
+    }
+    m_core[k][k] = inv_d;
+    m_lower[k][k] = m_upper[k][k] = real::R_1();
+}
+
+// Reduce the row maxima in row order. Ties go to the last point in scan
+// order, whatever the thread timings.
+void cross_solver::reduce()
+{
+    m_best = candidate { { 0, 0 }, real(0) };
+
+    for (auto const &row : m_row_best)
+        if (fabs(row.val) >= fabs(m_best.val))
+            m_best = row;
+
+    m_grid_error = fabs(m_best.val);
+}
+
+// Worker threads sample f along a grid row, apply the pending rank-1
+// update to a row of the residual and look for its largest value, or
+// check the approximation along a row of midpoints.
+int cross_solver::do_job(int i)
+{
+    int const kind = worker_pool::job_kind(i);
+
+    if (kind == check_job)
+    {
+        int const j = worker_pool::job_index(i);
+        real const &y = m_check_ys[j];
+        real err(0);
+
+        if (m_check)
+        {
+            for (auto const &x : m_check_xs)
+                err = max(err, fabs(m_func(x, y) - (*m_check)(x, y)));
+        }
+        else
+        {
+            std::vector<real> line;
+            eval_ek_line(y, m_check_xs, line);
+            for (auto const &e : line)
+                err = max(err, fabs(e));
+        }
+
+        m_row_error[j] = err;
+        return i;
+    }
+    else if (kind == sample_job)
+    {
+        int const y = worker_pool::job_index(i);
+        for (int x = 0; x <= m_grid_size; ++x)
+            m_residual[y][x] = m_func(m_xs[x], m_ys[y]);
+        return i;
+    }
+
+    int const y = worker_pool::job_index(i);
+    real *row = m_residual[y];
+
+    if (m_pivots.size())
+    {
+        index2 const &last = m_pivots.back();
+        real const &c = m_update_col[y];
+
+        for (int x = 0; x <= m_grid_size; ++x)
+            row[x] -= c * m_update_row[x];
+
+        /* The pivot’s row and column vanish; make it exact so that
+         * the pivot is never picked again */
+        if (y == last.y)
+            for (int x = 0; x <= m_grid_size; ++x)
+                row[x] = real::R_0();
+        row[last.x] = real::R_0();
+    }
+
+    candidate best { { 0, y }, real(0) };
+
+    for (int x = 0; x <= m_grid_size; ++x)
+    {
+        if (fabs(row[x]) >= fabs(best.val))
+            best = candidate { { x, y }, row[x] };
+    }
+
+    m_row_best[y] = best;
+    return i;
+}
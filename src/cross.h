@@ -0,0 +1,126 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The cross_solver class
+// ----------------------
+//
+// Separable approximation of a bivariate function by cross approximation:
+// each step picks the point (x_k,y_k) where the error e_{k-1} is largest
+// on a Chebyshev grid and subtracts e_{k-1}(x,y_k)·e_{k-1}(x_k,y)/e_{k-1}(x_k,y_k),
+// so that after k steps
+//   f(x,y) ≈ Σ d_k·g_k(x)·h_k(y)
+// where g_k and h_k are combinations of f along the pivot lines.
+//
+
+#include <lol/real>
+
+#include <functional>
+#include <vector>
+
+#include "matrix.h"
+#include "pool.h"
+
+class cross_solver
+{
+public:
+    typedef std::function<lol::real(lol::real const &, lol::real const &)> function;
+
+    // Sample f on a (grid_size + 1)² Chebyshev grid over the given ranges;
+    // f must be safe to call from several threads
+    cross_solver(function const &f, lol::real const &xmin, lol::real const &xmax,
+                 lol::real const &ymin, lol::real const &ymax,
+                 int grid_size, int max_rank);
+
+    // Add the pivot found by the last grid scan, then scan the grid again
+    void step();
+
+    int rank() const { return (int)m_pivots.size(); }
+
+    // Largest |e_k| on the sampling grid
+    lol::real grid_error() const { return m_grid_error; }
+
+    // Largest |f - approx| halfway between grid points, where the solver
+    // never looked. Without an approximation, the current cross
+    // approximation is checked.
+    lol::real check_error();
+    lol::real check_error(function const &approx);
+
+    // The separable factors, with d_k folded into g_k
+    lol::real eval_g(int k, lol::real const &x) const;
+    lol::real eval_h(int k, lol::real const &y) const;
+
+    // Evaluate e_k(x,y) for each x in xs, at a given y
+    void eval_ek_line(lol::real const &y, std::vector<lol::real> const &xs,
+                      std::vector<lol::real> &ret) const;
+
+private:
+    void update_core(int x, int y);
+    void reduce();
+    int do_job(int i);
+
+    function m_func;
+    int m_grid_size, m_max_rank;
+
+    // Grid coordinates, and midpoints used for checking
+    std::vector<lol::real> m_xs, m_ys;
+    std::vector<lol::real> m_check_xs, m_check_ys;
+
+    // A point of the grid, as indices into m_xs and m_ys
+    struct index2
+    {
+        int x, y;
+    };
+
+    std::vector<index2> m_pivots;
+
+    /*
+     * The error function e_k sampled on the grid; it starts as f itself.
+     * Each pivot subtracts a rank-1 term, which is applied by the workers
+     * during the next scan, so that a step costs O(grid²) operations
+     * regardless of the rank.
+     */
+    array2d<lol::real> m_residual;
+
+    // The last pivot’s residual column, divided by d_k, and row
+    std::vector<lol::real> m_update_col, m_update_row;
+
+    /*
+     * The same function in factored form, e_k(x,y) = f(x,y) minus
+     * Σ_ab f(x,y_a)·w_ab·f(x_b,y), where the core W = (w_ab) is the
+     * inverse of the k×k matrix of f at the pivots. It is bordered with one
+     * row and column per new pivot. Row k of m_lower and m_upper holds the
+     * coefficients of g_k and h_k in terms of f(x,y_a) and f(x_b,y).
+     */
+    array2d<lol::real> m_core, m_lower, m_upper;
+    std::vector<lol::real> m_inv_d;
+
+    // Grid scan results: best point of each row, and overall
+    struct candidate
+    {
+        index2 pivot;
+        lol::real val;
+    };
+
+    std::vector<candidate> m_row_best;
+    candidate m_best;
+    lol::real m_grid_error;
+
+    // Check results, one per row, and the approximation being checked
+    std::vector<lol::real> m_row_error;
+    function const *m_check = nullptr;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
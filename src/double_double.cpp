@@ -0,0 +1,197 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+#include <cmath>     // std::fma
+
+#include <lol/real>
+#include <lol/math>
+
+#include "double_double.h"
+#include "target.h"
+
+using lol::real;
+
+dd_horner::dd_horner(lol::polynomial<real> const &p)
+  : m_poly(p)
+{
+    // Split every coefficient; only the first m_steps use their low part
+    for (int j = 0; j <= p.degree(); ++j)
+    {
+        real const hi = round_to(p[j], number_type::float64);
+        m_hi.push_back(double(hi));
+        m_lo.push_back(double(round_to(p[j] - hi, number_type::float64)));
+    }
+}
+
+real dd_horner::error_bound(real const &x, int steps) const
+{
+    int const n = m_poly.degree();
+    real const u = ldexp(real::R_1(), -53);
+    real const u2 = u * u;
+    real const ax = fabs(x);
+
+    // Coefficients as stored: double, or double-double
+    real ret = 0;
+    for (int j = n; j >= 0; --j)
+        ret = ret * ax + fabs(m_poly[j] - real(m_hi[j]) - (j < steps ? real(m_lo[j]) : real::R_0()));
+
+    // Double steps: one rounding for the product and one for the sum, each
+    // at most u relative, and the error so far gets multiplied by x
+    real v = steps > n ? real(m_hi[n]) + real(m_lo[n]) : real(m_hi[n]), e = 0;
+    for (int j = n - 1; j >= steps; --j)
+    {
+        real const t = round_to(v * x, number_type::float64);
+        v = round_to(t + real(m_hi[j]), number_type::float64);
+        e = ax * e + u * fabs(t) + u * fabs(v);
+    }
+
+    // Double-double steps: TwoProd and TwoSum are exact, and what remains
+    // is the rounding of the low parts, which is a conservative 4u² of
+    // the operands (Joldes, Muller and Popescu, “Tight and rigorous error
+    // bounds for basic building blocks of double-word arithmetic”, 2017)
+    for (int j = std::min(n, steps) - 1; j >= 0; --j)
+    {
+        real const c = real(m_hi[j]) + real(m_lo[j]);
+        e = ax * e + 4 * u2 * (fabs(v * x) + fabs(c));
+        v = v * x + c;
+    }
+
+    return ret + e;
+}
+
+void dd_horner::select(expression const &func, real const &xmin,
+                       real const &xmax, int samples)
+{
+    int const n = m_poly.degree();
+    std::vector<real> xs, units;
+    double approximation = 0;
+
+    for (int i = 0; i < samples; ++i)
+    {
+        real const x = round_to(xmin + (xmax - xmin) * real(i) / real(samples - 1),
+                                number_type::float64);
+        real const fx = func.eval(x);
+        real const unit = ulp(fx, number_type::float64);
+        approximation = std::max(approximation, double(fabs(m_poly.eval(x) - fx) / unit));
+        xs.push_back(x);
+        units.push_back(unit);
+    }
+
+    double const target = std::max(approximation, std::ldexp(1.0, -20));
+    for (m_steps = 0; m_steps <= n; ++m_steps)
+    {
+        double evaluation = 0;
+        for (size_t i = 0; i < xs.size(); ++i)
+            evaluation = std::max(evaluation, double(error_bound(xs[i], m_steps) / units[i]));
+        if (evaluation <= target)
+            break;
+    }
+}
+
+dd_report dd_horner::verify(expression const &func, real const &xmin,
+                            real const &xmax, int samples) const
+{
+    dd_report ret;
+
+    for (int i = 0; i < samples; ++i)
+    {
+        real const x = round_to(xmin + (xmax - xmin) * real(i) / real(samples - 1),
+                                number_type::float64);
+        real const fx = func.eval(x);
+        real const unit = ulp(fx, number_type::float64);
+
+        double const approximation = double(fabs(m_poly.eval(x) - fx) / unit);
+        double const evaluation = double(error_bound(x, m_steps) / unit);
+
+        ret.approximation = std::max(ret.approximation, approximation);
+        ret.evaluation = std::max(ret.evaluation, evaluation);
+        ret.total = std::max(ret.total, approximation + evaluation + 0.5);
+        ret.observed = std::max(ret.observed, double(fabs(real(eval(double(x))) - fx) / unit));
+        ++ret.count;
+    }
+
+    return ret;
+}
+
+double dd_horner::eval(double x) const
+{
+    int const n = m_poly.degree();
+    int const top = std::min(n, m_steps);
+
+    double uh = m_hi[n], ul = m_steps > n ? m_lo[n] : 0.0;
+    for (int j = n - 1; j >= top; --j)
+        uh = uh * x + m_hi[j];
+
+    for (int j = top - 1; j >= 0; --j)
+    {
+        // TwoProd, then TwoSum, then renormalisation
+        double const p = uh * x;
+        double e = std::fma(uh, x, -p) + ul * x;
+        double const s = p + m_hi[j];
+        double const t = s - p;
+        e += (p - (s - t)) + (m_hi[j] - t) + m_lo[j];
+        uh = s + e;
+        ul = e - (uh - s);
+    }
+
+    return uh + ul;
+}
+
+void dd_horner::emit(std::ostream &os, std::string const &name, bool hex) const
+{
+    int const n = m_poly.degree();
+    int const top = std::min(n, m_steps);
+    auto hi = [&](int j) { return format_literal(real(m_hi[j]), number_type::float64, hex); };
+    auto lo = [&](int j) { return format_literal(real(m_lo[j]), number_type::float64, hex); };
+
+    if (m_steps)
+        os << "#include <math.h>\n\n"
+           << "// The " << m_steps << " lowest-degree coefficients are unevaluated sums hi + lo,\n"
+           << "// and their Horner steps use double-double arithmetic. Compile with\n"
+           << "// -ffp-contract=off: contracting “p + hi” below into an FMA would\n"
+           << "// break the error-free transforms.\n";
+
+    os << "double " << name << "(double x)\n{\n";
+    if (m_steps > n)
+        os << "    double uh = " << hi(n) << ", ul = " << lo(n) << ";\n";
+    else
+        os << "    double u" << (top ? "h" : "") << " = " << hi(n) << ";\n";
+    for (int j = n - 1; j >= top; --j)
+        os << "    u" << (top ? "h" : "") << " = u" << (top ? "h" : "") << " * x + " << hi(j) << ";\n";
+
+    if (!m_steps)
+    {
+        os << "    return u;\n}\n";
+        return;
+    }
+
+    if (m_steps <= n)
+        os << "    double ul = 0.0;\n";
+    if (top)
+        os << "    double p, e, s, t;\n";
+    for (int j = top - 1; j >= 0; --j)
+    {
+        os << "    p = uh * x;\n"
+           << "    e = fma(uh, x, -p) + ul * x;\n"
+           << "    s = p + " << hi(j) << ";\n"
+           << "    t = s - p;\n"
+           << "    e += (p - (s - t)) + (" << hi(j) << " - t) + " << lo(j) << ";\n"
+           << "    uh = s + e;\n"
+           << "    ul = e - (uh - s);\n";
+    }
+    os << "    return uh + ul;\n}\n";
+}
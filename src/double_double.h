@@ -0,0 +1,75 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The dd_horner class
+// -------------------
+//
+// Horner evaluation in double where the last steps, i.e. those of the
+// lowest-degree coefficients, are done in double-double arithmetic: these
+// coefficients are stored as unevaluated sums hi + lo, and each step uses
+// the FMA-based error-free transforms TwoProd and TwoSum.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+
+struct dd_report
+{
+    // All errors are in double ulps of f(x)
+    double approximation = 0; // |p(x) - f(x)|, exact coefficients
+    double evaluation = 0;    // bound on coefficient splitting and arithmetic
+    double total = 0;         // max of the sum of the above, plus ½ ulp
+    double observed = 0;      // actual error of the generated code
+    int count = 0;            // number of samples
+};
+
+class dd_horner
+{
+public:
+    dd_horner(lol::polynomial<lol::real> const &p);
+
+    // Use double-double for more and more steps, starting with the
+    // constant term, until the evaluation error no longer exceeds the
+    // approximation error (or 2^-20 ulp, below which there is no point).
+    void select(expression const &func, lol::real const &xmin,
+                lol::real const &xmax, int samples = 256);
+
+    // Number of coefficients stored as hi + lo
+    int steps() const { return m_steps; }
+
+    // Error bounds, and actual error of eval() against func
+    dd_report verify(expression const &func, lol::real const &xmin,
+                     lol::real const &xmax, int samples = 2048) const;
+
+    // Evaluate exactly as the generated code does
+    double eval(double x) const;
+
+    void emit(std::ostream &os, std::string const &name, bool hex) const;
+
+private:
+    // Bound on the evaluation error at x with the given number of
+    // double-double coefficients
+    lol::real error_bound(lol::real const &x, int steps) const;
+
+    lol::polynomial<lol::real> m_poly;
+    std::vector<double> m_hi, m_lo;
+    int m_steps = 0;
+};
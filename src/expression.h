@@ -24,8 +24,10 @@
 #include <lol/pegtl>
 #include <vector>
 #include <map>
+#include <optional>
 #include <tuple>
 #include <cassert>
+#include <algorithm> // std::max
 
 namespace grammar
 {
@@ -36,7 +38,7 @@ using long_double = long double;
 enum class id : uint8_t
 {
     /* Variables and constants */
-    x, y,
+    x, y, z, w,
     constant,
     /* Unary functions/operators */
     plus, minus, abs,
@@ -58,9 +60,26 @@ enum class id : uint8_t
 struct expression
 {
     /*
-     * Evaluate expression at x
+     * Evaluate expression at x, with y = 0
      */
     lol::real eval(lol::real const &x) const
+    {
+        return eval(x, lol::real::R_0());
+    }
+
+    /*
+     * Evaluate expression at (x,y), with z = w = 0
+     */
+    lol::real eval(lol::real const &x, lol::real const &y) const
+    {
+        return eval(x, y, lol::real::R_0(), lol::real::R_0());
+    }
+
+    /*
+     * Evaluate expression at (x,y,z,w)
+     */
+    lol::real eval(lol::real const &x, lol::real const &y,
+                   lol::real const &z, lol::real const &w) const
     {
         /* Use a stack */
         std::vector<lol::real> stack;
@@ -87,7 +106,17 @@ struct expression
             }
             else if (std::get<0>(m_ops[i]) == id::y)
             {
-                push_val(0); // TODO
+                push_val(y);
+                continue;
+            }
+            else if (std::get<0>(m_ops[i]) == id::z)
+            {
+                push_val(z);
+                continue;
+            }
+            else if (std::get<0>(m_ops[i]) == id::w)
+            {
+                push_val(w);
                 continue;
             }
             else if (std::get<0>(m_ops[i]) == id::constant)
@@ -145,6 +174,8 @@ struct expression
 
             case id::x:
             case id::y:
+            case id::z:
+            case id::w:
             case id::constant:
                 /* Already handled above */
                 break;
@@ -156,15 +187,109 @@ struct expression
     }
 
     /*
-     * Is expression constant? i.e. does not depend on x
+     * Evaluate expression at x, with y = z = w = 0, using another
+     * arithmetic type T such as Taylor series. T must be constructible
+     * from lol::real and provide the same operators and functions.
+     * Returns nothing if the expression uses atan2, min, max, % or fmod,
+     * or a conversion, which are only defined for numbers.
+     */
+    template<typename T>
+    std::optional<T> eval_as(T const &x) const
+    {
+        std::vector<T> stack;
+
+        auto pop_val = [&stack]() -> T
+        {
+            auto ret = stack.back();
+            stack.pop_back();
+            return ret;
+        };
+
+        for (auto const &op : m_ops)
+        {
+            switch (std::get<0>(op))
+            {
+            case id::x: stack.push_back(x); continue;
+            case id::y:
+            case id::z:
+            case id::w: stack.push_back(T(lol::real::R_0())); continue;
+            case id::constant: stack.push_back(T(m_constants[std::get<1>(op)])); continue;
+            default: break;
+            }
+
+            T head = pop_val();
+
+            switch (std::get<0>(op))
+            {
+            case id::plus:  stack.push_back(head);  break;
+            case id::minus: stack.push_back(-head); break;
+
+            case id::abs:   stack.push_back(fabs(head));  break;
+            case id::sqrt:  stack.push_back(sqrt(head));  break;
+            case id::cbrt:  stack.push_back(cbrt(head));  break;
+            case id::exp:   stack.push_back(exp(head));   break;
+            case id::expm1: stack.push_back(expm1(head)); break;
+            case id::exp2:  stack.push_back(exp2(head));  break;
+            case id::erf:   stack.push_back(erf(head));   break;
+            case id::erfc:  stack.push_back(erfc(head));  break;
+            case id::erfcx: stack.push_back(erfcx(head)); break;
+            case id::log:   stack.push_back(log(head));   break;
+            case id::log1p: stack.push_back(log1p(head)); break;
+            case id::log2:  stack.push_back(log2(head));  break;
+            case id::log10: stack.push_back(log10(head)); break;
+            case id::sin:   stack.push_back(sin(head));   break;
+            case id::cos:   stack.push_back(cos(head));   break;
+            case id::tan:   stack.push_back(tan(head));   break;
+            case id::asin:  stack.push_back(asin(head));  break;
+            case id::acos:  stack.push_back(acos(head));  break;
+            case id::atan:  stack.push_back(atan(head));  break;
+            case id::sinh:  stack.push_back(sinh(head));  break;
+            case id::cosh:  stack.push_back(cosh(head));  break;
+            case id::tanh:  stack.push_back(tanh(head));  break;
+
+            case id::add:   stack.push_back(pop_val() + head); break;
+            case id::sub:   stack.push_back(pop_val() - head); break;
+            case id::mul:   stack.push_back(pop_val() * head); break;
+            case id::div:   stack.push_back(pop_val() / head); break;
+            case id::pow:   stack.push_back(pow(pop_val(), head)); break;
+
+            default:
+                return std::nullopt;
+            }
+        }
+
+        assert(stack.size() == 1);
+        return stack.back();
+    }
+
+    /*
+     * Is expression constant? i.e. does not depend on any variable
      */
     bool is_constant() const
     {
+        return variables() == 0;
+    }
+
+    /*
+     * Number of variables, in the order x, y, z, w, needed to evaluate
+     * the expression; e.g. 3 if it uses z but not w
+     */
+    int variables() const
+    {
+        int ret = 0;
         for (auto const &op : m_ops)
-            if (std::get<0>(op) == id::x)
-                return false;
+        {
+            switch (std::get<0>(op))
+            {
+            case id::w: ret = std::max(ret, 4); break;
+            case id::z: ret = std::max(ret, 3); break;
+            case id::y: ret = std::max(ret, 2); break;
+            case id::x: ret = std::max(ret, 1); break;
+            default: break;
+            }
+        }
 
-        return true;
+        return ret;
     }
 
 private:
@@ -211,11 +336,13 @@ private:
     // r_sup_float <- <r_sup_digit> +
     struct r_sup_float : plus<r_sup_digit> {};
 
-    // r_name <- r_hex_float / r_float / "x" / "y" / "e" / "pi" / "π" / "tau" / "τ"
+    // r_name <- r_hex_float / r_float / "x" / "y" / "z" / "w" / "e" / "pi" / "π" / "tau" / "τ"
     struct r_name : sor<r_hex_float,
                         r_float,
                         TAO_PEGTL_STRING("x"),
                         TAO_PEGTL_STRING("y"),
+                        TAO_PEGTL_STRING("z"),
+                        TAO_PEGTL_STRING("w"),
                         TAO_PEGTL_STRING("e"),
                         TAO_PEGTL_STRING("pi"),
                         TAO_PEGTL_STRING("π"),
@@ -505,6 +632,10 @@ struct expression::action<expression::r_name>
             that->m_ops.push_back(std::make_tuple(id::x, -1));
         else if (in.string() == "y")
             that->m_ops.push_back(std::make_tuple(id::y, -1));
+        else if (in.string() == "z")
+            that->m_ops.push_back(std::make_tuple(id::z, -1));
+        else if (in.string() == "w")
+            that->m_ops.push_back(std::make_tuple(id::w, -1));
         else
         {
             that->m_ops.push_back(std::make_tuple(id::constant, (int)that->m_constants.size()));
@@ -0,0 +1,391 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::fabs, std::ldexp, std::erfc
+#include <cstdio>    // sscanf
+#include <functional>
+#include <iostream>
+#include <limits>
+
+#include <lol/real>
+#include <lol/math>
+
+#include "fixed.h"
+#include "pool.h"
+
+using lol::real;
+
+namespace
+{
+
+// Numbers for expression::eval_as() that use double precision; this is
+// accurate enough for a reference measured in LSBs of a format of at most
+// 32 bits, and much faster than lol::real for all those inputs.
+struct dreal
+{
+    dreal(double x = 0.0) : v(x) {}
+    explicit dreal(real const &x) : v(double(x)) {}
+
+    double v;
+};
+
+dreal operator -(dreal a) { return -a.v; }
+dreal operator +(dreal a, dreal b) { return a.v + b.v; }
+dreal operator -(dreal a, dreal b) { return a.v - b.v; }
+dreal operator *(dreal a, dreal b) { return a.v * b.v; }
+dreal operator /(dreal a, dreal b) { return a.v / b.v; }
+dreal pow(dreal a, dreal b) { return std::pow(a.v, b.v); }
+
+#define DREAL_FUNCTION(f) dreal f(dreal a) { return std::f(a.v); }
+DREAL_FUNCTION(fabs) DREAL_FUNCTION(sqrt) DREAL_FUNCTION(cbrt)
+DREAL_FUNCTION(exp) DREAL_FUNCTION(expm1) DREAL_FUNCTION(exp2)
+DREAL_FUNCTION(erf) DREAL_FUNCTION(erfc)
+DREAL_FUNCTION(log) DREAL_FUNCTION(log1p) DREAL_FUNCTION(log2) DREAL_FUNCTION(log10)
+DREAL_FUNCTION(sin) DREAL_FUNCTION(cos) DREAL_FUNCTION(tan)
+DREAL_FUNCTION(asin) DREAL_FUNCTION(acos) DREAL_FUNCTION(atan)
+DREAL_FUNCTION(sinh) DREAL_FUNCTION(cosh) DREAL_FUNCTION(tanh)
+#undef DREAL_FUNCTION
+
+// exp(x²)·erfc(x), which has no standard function; beyond x = 25 erfc()
+// underflows, so use the asymptotic series, whose next term is below 1e-12.
+dreal erfcx(dreal a)
+{
+    double const x = a.v;
+    if (x < 25.0)
+        return std::exp(x * x) * std::erfc(x);
+    double const t = 1.0 / (2.0 * x * x);
+    return (1.0 - t * (1.0 - 3.0 * t * (1.0 - 5.0 * t * (1.0 - 7.0 * t))))
+         / (x * 1.7724538509055160273);
+}
+
+}
+
+// Smallest e such that |x| < 2^e
+static int exponent(real const &x)
+{
+    int e;
+    frexp(x, &e);
+    return e;
+}
+
+static int64_t to_int64(real const &x)
+{
+    // All values we convert fit in 63 bits; go through two halves so
+    // that nothing is lost to the 53-bit mantissa of double.
+    real const hi = floor(ldexp(x, -32));
+    return int64_t(double(hi)) * (int64_t(1) << 32) + int64_t(double(x - ldexp(hi, 32)));
+}
+
+bool parse_fixed_format(std::string const &str, fixed_format &fmt)
+{
+    char c;
+    return sscanf(str.c_str(), "Q%d.%d%c", &fmt.m, &fmt.n, &c) == 2
+            && fmt.m >= 1 && fmt.n >= 0 && fmt.bits() >= 2 && fmt.bits() <= 32;
+}
+
+bool fixed_horner::init(lol::polynomial<real> const &p, fixed_format fmt,
+                        real const &xmin, real const &xmax)
+{
+    int const d = p.degree();
+    int const w = fmt.bits();
+
+    m_poly = p;
+    m_fmt = fmt;
+    m_storage = w <= 16 ? 16 : 32;
+    int const wide = 2 * m_storage;
+
+    // Inputs are all representable numbers in [xmin, xmax]
+    real const lo = ceil(ldexp(xmin, fmt.n)), hi = floor(ldexp(xmax, fmt.n));
+    real const limit = ldexp(real::R_1(), w - 1);
+    if (lo < -limit || hi >= limit || lo > hi)
+    {
+        std::cout << "Error: range [ " << xmin << ", " << xmax << " ] does not fit in Q"
+                  << fmt.m << '.' << fmt.n << '\n';
+        return false;
+    }
+    m_xlo = to_int64(lo);
+    m_xhi = to_int64(hi);
+
+    // Range of the intermediate Horner values u_j = c_j + x u_(j+1), with
+    // a margin for what sampling misses and for rounding errors.
+    int const samples = 1024;
+    std::vector<real> range(d + 1, real::R_0());
+    for (int i = 0; i <= samples; ++i)
+    {
+        real const x = xmin + (xmax - xmin) * real(i) / real(samples);
+        real u = p[d];
+        range[d] = max(range[d], fabs(u));
+        for (int j = d - 1; j >= 0; --j)
+        {
+            u = u * x + p[j];
+            range[j] = max(range[j], fabs(u));
+        }
+    }
+
+    // Fractional bits of each u_j, from the top: as many as fit in w bits,
+    // but no more than the product with x provides, and few enough that
+    // the constant of the next step fits in the wide type along with the
+    // product. The result u_0 is in the output format.
+    m_frac.assign(d + 1, 0);
+    for (int j = d; j >= 0; --j)
+    {
+        int g = w - 1 - exponent(range[j] * (real::R_1() + real(1) / 64));
+        if (range[j].is_zero())
+            g = wide;
+        if (j < d)
+            g = std::min(g, m_frac[j + 1] + fmt.n);
+        if (j > 0)
+        {
+            g = std::min(g, wide - 2 - fmt.n);
+            if (!p[j - 1].is_zero())
+                g = std::min(g, wide - 3 - exponent(p[j - 1]) - fmt.n);
+        }
+        else
+        {
+            if (g < fmt.n)
+            {
+                std::cout << "Error: polynomial values up to " << range[0]
+                          << " do not fit in Q" << fmt.m << '.' << fmt.n << '\n';
+                return false;
+            }
+            g = fmt.n;
+        }
+        m_frac[j] = g;
+    }
+
+    // Shifts, and constants with the rounding offset folded in
+    m_shift.assign(d, 0);
+    m_coeffs.assign(d + 1, 0);
+    m_coeffs[d] = to_int64(round(ldexp(p[d], m_frac[d])));
+    for (int j = d - 1; j >= 0; --j)
+    {
+        m_shift[j] = m_frac[j + 1] + fmt.n - m_frac[j];
+        if (m_shift[j] < 0)
+        {
+            std::cout << "Error: coefficients are too large for Q" << fmt.m << '.' << fmt.n << '\n';
+            return false;
+        }
+        m_coeffs[j] = to_int64(round(ldexp(p[j], m_frac[j + 1] + fmt.n)));
+        if (m_shift[j] > 0)
+            m_coeffs[j] += int64_t(1) << (m_shift[j] - 1);
+    }
+
+    return true;
+}
+
+int64_t fixed_horner::eval(int64_t x, bool *overflow) const
+{
+    int const d = int(m_coeffs.size()) - 1;
+    int64_t const umax = (int64_t(1) << (m_fmt.bits() - 1)) - 1;
+    int64_t const tmax = m_storage == 16 ? std::numeric_limits<int32_t>::max()
+                                         : std::numeric_limits<int64_t>::max();
+
+    int64_t u = m_coeffs[d];
+    bool bad = u > umax || u < -umax - 1;
+    for (int j = d - 1; j >= 0; --j)
+    {
+        int64_t const t = u * x + m_coeffs[j];
+        bad |= t > tmax || t < -tmax - 1;
+        u = t >> m_shift[j];
+        bad |= u > umax || u < -umax - 1;
+    }
+
+    if (overflow)
+        *overflow = bad;
+    return u;
+}
+
+// All inputs in [lo, hi] if there are at most “samples” of them, otherwise
+// that many evenly spaced ones
+static std::vector<int64_t> sample_inputs(int64_t lo, int64_t hi, int samples)
+{
+    std::vector<int64_t> ret;
+    uint64_t const count = uint64_t(hi - lo) + 1;
+    for (uint64_t i = 0; i < count && i < uint64_t(samples); ++i)
+        ret.push_back(count <= uint64_t(samples) ? lo + int64_t(i)
+                      : lo + int64_t((hi - lo) * (long double)i / (samples - 1)));
+    return ret;
+}
+
+void fixed_horner::optimize(expression const &func, int samples)
+{
+    // Inputs and reference values, in output LSBs
+    std::vector<int64_t> const inputs = sample_inputs(m_xlo, m_xhi, samples);
+    std::vector<double> targets;
+    for (int64_t x : inputs)
+        targets.push_back(double(ldexp(func.eval(ldexp(real(double(x)), -m_fmt.n)), m_fmt.n)));
+
+    auto max_error = [&]()
+    {
+        double ret = 0;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            bool overflow;
+            double const y = double(eval(inputs[i], &overflow));
+            if (overflow)
+                return std::numeric_limits<double>::infinity();
+            ret = std::max(ret, std::fabs(y - targets[i]));
+        }
+        return ret;
+    };
+
+    double best = max_error();
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        bool improved = false;
+        for (int j = int(m_coeffs.size()) - 1; j >= 0; --j)
+        {
+            // One LSB of the step result; half of that when the shift
+            // allows it, since the rounding offset is what matters most.
+            int const s = j < int(m_shift.size()) ? m_shift[j] : 0;
+            int64_t const step = s > 0 ? int64_t(1) << (s - 1) : 1;
+            for (int64_t delta : { -step, step })
+            {
+                m_coeffs[j] += delta;
+                double const e = max_error();
+                if (e < best)
+                {
+                    best = e;
+                    improved = true;
+                }
+                else
+                    m_coeffs[j] -= delta;
+            }
+        }
+
+        if (!improved)
+            break;
+    }
+}
+
+// Largest error of the reference of verify(), in output LSBs
+static double const reference_tolerance = 1.0 / 64;
+
+bool fixed_horner::can_verify_against(expression const &func, int samples) const
+{
+    if (!func.eval_as(dreal(0.0)))
+        return false;
+
+    // Inputs where f is not a finite number do not count
+    for (int64_t x : sample_inputs(m_xlo, m_xhi, samples))
+    {
+        real const rx = ldexp(real(double(x)), -m_fmt.n);
+        double const target = double(ldexp(func.eval(rx), m_fmt.n));
+        double const y = std::ldexp(func.eval_as(dreal(rx))->v, m_fmt.n);
+        if (std::isfinite(target) && !(std::fabs(y - target) <= reference_tolerance))
+            return false;
+    }
+    return true;
+}
+
+fixed_report fixed_horner::verify(expression const &func) const
+{
+    int const d = m_poly.degree();
+    std::vector<double> coeffs;
+    for (int j = 0; j <= d; ++j)
+        coeffs.push_back(double(m_poly[j]));
+
+    fixed_report ret;
+    ret.against_func = can_verify_against(func);
+
+    // Split the inputs into jobs for the worker pool, at low priority since
+    // this can take a while; the reference, f or the polynomial, is
+    // evaluated in double.
+    int const jobs = 16 * worker_pool::size();
+    std::vector<fixed_report> reports(jobs);
+    uint64_t const count = uint64_t(m_xhi - m_xlo) + 1;
+
+    worker_pool::client pool([&](int t)
+    {
+        fixed_report &r = reports[t];
+        int64_t const first = m_xlo + int64_t(count * t / jobs);
+        int64_t const last = m_xlo + int64_t(count * (t + 1) / jobs);
+        for (int64_t x = first; x < last; ++x)
+        {
+            bool overflow;
+            double const y = double(eval(x, &overflow));
+            double const fx = std::ldexp(double(x), -m_fmt.n);
+            double p = coeffs[d];
+            if (ret.against_func)
+                p = func.eval_as(dreal(fx))->v;
+            else
+                for (int j = d - 1; j >= 0; --j)
+                    p = p * fx + coeffs[j];
+            double const e = std::fabs(y - std::ldexp(p, m_fmt.n));
+            if (e > r.max_error)
+            {
+                r.max_error = e;
+                r.worst_x = x;
+            }
+            r.overflow |= overflow;
+            ++r.count;
+        }
+        return t;
+    }, worker_pool::priority::batch);
+
+    for (int t = 0; t < jobs; ++t)
+        pool.push(t);
+    for (int t = 0; t < jobs; ++t)
+        pool.pop();
+
+    for (auto const &r : reports)
+    {
+        if (r.max_error > ret.max_error)
+        {
+            ret.max_error = r.max_error;
+            ret.worst_x = r.worst_x;
+        }
+        ret.overflow |= r.overflow;
+        ret.count += r.count;
+    }
+    return ret;
+}
+
+void fixed_horner::emit(std::ostream &os, std::string const &name) const
+{
+    int const d = int(m_coeffs.size()) - 1;
+    std::string const type = m_storage == 16 ? "int16_t" : "int32_t";
+    std::string const wtype = m_storage == 16 ? "int32_t" : "int64_t";
+    std::string const wconst = m_storage == 16 ? "INT32_C" : "INT64_C";
+
+    os << "#include <stdint.h>\n\n";
+    os << "// Q" << m_fmt.m << '.' << m_fmt.n << " input and output, i.e. " << m_fmt.n
+       << " fractional bits; right shifts\n// of negative numbers are assumed to be arithmetic.\n";
+    os << type << ' ' << name << '(' << type << " x)\n{\n";
+
+    if (d == 0)
+    {
+        os << "    return " << m_coeffs[0] << ";\n}\n";
+        return;
+    }
+
+    os << "    " << type << " u = " << m_coeffs[d] << "; // "
+       << m_frac[d] << " fractional bits\n";
+    for (int j = d - 1; j >= 0; --j)
+    {
+        std::string const step = "(" + wtype + ")u * x + " + wconst + "("
+                               + std::to_string(m_coeffs[j]) + ")";
+        std::string const value = m_shift[j] ? "(" + step + ") >> " + std::to_string(m_shift[j])
+                                             : step;
+        if (j > 0)
+            os << "    u = (" << type << ")(" << value << "); // "
+               << m_frac[j] << " fractional bits\n";
+        else
+            os << "    return (" << type << ")(" << value << ");\n";
+    }
+    os << "}\n";
+}
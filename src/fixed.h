@@ -0,0 +1,94 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The fixed_horner class
+// ----------------------
+//
+// Integer-only Horner evaluation of a polynomial for a Qm.n input and
+// output. Each step computes u = (u * x + C) >> s with a widening
+// multiply; the intermediate values u carry their own count of fractional
+// bits, chosen from their range so that nothing overflows, and the rounding
+// offset of each shift is folded into the constant C.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+
+struct fixed_format
+{
+    // Integer bits, including the sign bit, and fractional bits
+    int m = 2, n = 30;
+
+    int bits() const { return m + n; }
+};
+
+// Parse a “Qm.n” string
+bool parse_fixed_format(std::string const &str, fixed_format &fmt);
+
+struct fixed_report
+{
+    double max_error = 0;      // in output LSBs
+    int64_t worst_x = 0;       // integer representation of the worst input
+    uint64_t count = 0;        // number of inputs checked
+    bool overflow = false;
+    bool against_func = false; // otherwise against the polynomial
+};
+
+class fixed_horner
+{
+public:
+    // Quantise p for inputs in [xmin, xmax]. Prints an error and returns
+    // false if the format cannot hold the inputs or the results.
+    bool init(lol::polynomial<lol::real> const &p, fixed_format fmt,
+              lol::real const &xmin, lol::real const &xmax);
+
+    // Greedily move the quantised constants by ±1 LSB of their step for
+    // as long as the maximum error against func decreases, on a set of
+    // at most “samples” inputs.
+    void optimize(expression const &func, int samples = 4096);
+
+    // Compare the integer code to f for every input, with f evaluated in
+    // double precision. If f uses functions that this cannot evaluate, or
+    // if that is off by more than 1/64 LSB on a sample of inputs checked
+    // with lol::real, compare to the polynomial instead; the approximation
+    // error then has to be added to get a bound of the error against f.
+    fixed_report verify(expression const &func) const;
+
+    // Evaluate exactly as the generated code does
+    int64_t eval(int64_t x, bool *overflow = nullptr) const;
+
+    void emit(std::ostream &os, std::string const &name) const;
+
+private:
+    // Whether f evaluated in double can serve as the reference of verify()
+    bool can_verify_against(expression const &func, int samples = 4096) const;
+
+    lol::polynomial<lol::real> m_poly;
+    fixed_format m_fmt;
+    int64_t m_xlo = 0, m_xhi = 0; // input range, as integers
+    int m_storage = 32;           // bits of the storage type, 16 or 32
+
+    // Constant added at each step (m_coeffs[degree] is the initial value),
+    // fractional bits of each intermediate value, and shift of each step
+    std::vector<int64_t> m_coeffs;
+    std::vector<int> m_frac, m_shift;
+};
@@ -0,0 +1,219 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::min, std::max
+#include <functional>
+#include <iostream>
+#include <iomanip>
+
+#include <lol/real>
+
+#include "lawson.h"
+
+using lol::real;
+
+/* Points are processed by chunks. Kinds of worker jobs: building the
+ * normal equations of chunk c is job c of normal_job, computing its
+ * errors is job c of error_job, and sampling chunk c of the grid of
+ * lawson_solver is job c of sample_job. */
+static int const chunk = 64;
+static int const normal_job = 1;
+static int const error_job = 2;
+static int const sample_job = 3;
+
+static int chunks(size_t n)
+{
+    return int((n + chunk - 1) / chunk);
+}
+
+lawson_core::lawson_core()
+  : m_pool([this](int i) { return do_job(i); })
+{
+}
+
+void lawson_core::step()
+{
+    size_t const size = m_points.empty() ? 0 : m_points[0].basis.size();
+    int const n = chunks(m_points.size());
+
+    real total(0);
+    for (auto const &p : m_points)
+        total += p.weight;
+    for (auto &p : m_points)
+        p.weight = total.is_zero() ? real::R_1() / real(int(m_points.size())) : p.weight / total;
+
+    // Weighted least squares: (Σ w·φ·φᵀ)·c = Σ w·f·φ
+    while ((int)m_chunk_matrix.size() < n)
+    {
+        m_chunk_matrix.emplace_back(size);
+        m_chunk_rhs.emplace_back(size);
+    }
+    m_pool.run(normal_job, n);
+
+    linear_system<real> a(size);
+    a.init(real::R_0());
+    std::vector<real> rhs(size);
+    for (int c = 0; c < n; ++c)
+        for (size_t r = 0; r < size; ++r)
+        {
+            for (size_t s = 0; s < size; ++s)
+                a[r][s] += m_chunk_matrix[c][r][s];
+            rhs[r] += m_chunk_rhs[c][r];
+        }
+
+    auto const inv = a.inverse();
+    m_solution.assign(size, real::R_0());
+    for (size_t r = 0; r < size; ++r)
+        for (size_t s = 0; s < size; ++s)
+            m_solution[r] += inv[r][s] * rhs[s];
+
+    // Errors; with weights summing to 1, the weighted L2 error is a lower
+    // bound on the minimax error on the points
+    m_chunk_error.resize(n);
+    m_pool.run(error_job, n);
+
+    m_error = real::R_0();
+    for (int c = 0; c < n; ++c)
+        m_error = max(m_error, m_chunk_error[c]);
+
+    real sum(0), l2(0);
+    for (auto const &p : m_points)
+    {
+        l2 += p.weight * p.err * p.err;
+        sum += p.weight * fabs(p.err);
+    }
+    m_lower = sqrt(l2);
+
+    // Lawson’s update, which keeps the weights summing to 1
+    if (!sum.is_zero())
+        for (auto &p : m_points)
+            p.weight = p.weight * fabs(p.err) / sum;
+}
+
+// Worker threads handle jobs from the main thread, each on a chunk of
+// points.
+int lawson_core::do_job(int i)
+{
+    int const kind = worker_pool::job_kind(i), c = worker_pool::job_index(i);
+    size_t const size = m_points[0].basis.size();
+    size_t const end = std::min(m_points.size(), size_t(c + 1) * chunk);
+
+    if (kind == error_job)
+    {
+        real err(0);
+        for (size_t k = size_t(c) * chunk; k < end; ++k)
+        {
+            auto &p = m_points[k];
+            p.err = -p.fx;
+            for (size_t b = 0; b < size; ++b)
+                p.err += m_solution[b] * p.basis[b];
+            err = max(err, fabs(p.err));
+        }
+        m_chunk_error[c] = err;
+    }
+    else if (kind == normal_job)
+    {
+        auto &a = m_chunk_matrix[c];
+        auto &rhs = m_chunk_rhs[c];
+        a.init(real::R_0());
+        rhs.assign(size, real::R_0());
+
+        for (size_t k = size_t(c) * chunk; k < end; ++k)
+        {
+            auto const &p = m_points[k];
+            if (p.weight.is_zero())
+                continue;
+            for (size_t r = 0; r < size; ++r)
+            {
+                real const wr = p.weight * p.basis[r];
+                for (size_t s = r; s < size; ++s)
+                    a[r][s] += wr * p.basis[s];
+                rhs[r] += wr * p.fx;
+            }
+        }
+        for (size_t r = 0; r < size; ++r)
+            for (size_t s = 0; s < r; ++s)
+                a[r][s] = a[s][r];
+    }
+
+    return i;
+}
+
+lawson_solver::lawson_solver(function const &f, function const &g, real const &xmin,
+                             real const &xmax, int order, int grid_size)
+  : m_func(f),
+    m_weight(g),
+    m_order(order),
+    m_k1((xmax + xmin) / 2),
+    m_k2((xmax - xmin) / 2),
+    m_pool([this](int i) { return do_job(i); })
+{
+    // Chebyshev extrema, many more of them than there are coefficients
+    int const n = grid_size > 0 ? grid_size : std::max(512, 32 * (order + 1));
+    m_ts.resize(n + 1);
+    for (int i = 0; i <= n; ++i)
+        m_ts[i] = -cos(real::R_PI() * i / n);
+
+    m_core.points().resize(n + 1);
+    m_pool.run(sample_job, chunks(m_ts.size()));
+}
+
+bool lawson_solver::solve(double gap, int max_iterations, bool show_progress)
+{
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        fprintf(stderr, "Lawson iteration: %d\r", iteration);
+        fflush(stderr);
+
+        m_core.step();
+        real const error = m_core.get_error(), lower = m_core.get_lower_bound();
+        if (show_progress)
+            std::cout << "lawson iteration " << iteration << ": error "
+                      << std::setprecision(3) << lower << " to " << error << '\n';
+
+        if (error - lower <= error * real(gap))
+            return true;
+    }
+
+    return false;
+}
+
+// Worker threads sample chunks of grid points.
+int lawson_solver::do_job(int i)
+{
+    int const c = worker_pool::job_index(i);
+    size_t const size = m_order + 1;
+    size_t const end = std::min(m_ts.size(), size_t(c + 1) * chunk);
+    real const weight = real::R_1() / real(int(m_ts.size()));
+
+    for (size_t k = size_t(c) * chunk; k < end; ++k)
+    {
+        auto &p = m_core.points()[k];
+        real const &t = m_ts[k];
+        real const x = t * m_k2 + m_k1;
+        real const g = m_weight ? real::R_1() / fabs(m_weight(x)) : real::R_1();
+
+        // T_n(t) from the three-term recurrence
+        p.basis.resize(size);
+        for (size_t b = 0; b < size; ++b)
+            p.basis[b] = b == 0 ? g : b == 1 ? t * g
+                       : 2 * t * p.basis[b - 1] - p.basis[b - 2];
+        p.fx = m_func(x) * g;
+        p.weight = weight;
+    }
+
+    return i;
+}
@@ -0,0 +1,125 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The lawson_core class
+// ---------------------
+//
+// Lawson’s algorithm on a set of points, whatever the basis. Each step
+// solves the weighted least squares problem
+//   (Σ w·φ·φᵀ)·c = Σ w·f·φ
+// where φ holds the values of the basis functions at a point, then
+// multiplies each weight by the error at its point:
+//   w_i ← w_i·|e_i| / Σ w_j·|e_j|
+// The caller chooses the points and fills in φ, f and the initial weights.
+//
+// The lawson_solver class
+// -----------------------
+//
+// Minimax polynomial on a dense grid by Lawson’s algorithm, in the basis
+// of Chebyshev polynomials. Unlike the Remez exchange, it makes no
+// assumption on the number of extrema of the error, so it converges, if
+// slowly, even when Remez does not; its result is also a good starting
+// point for Remez.
+//
+
+#include <lol/real>
+
+#include <functional>
+#include <vector>
+
+#include "matrix.h"
+#include "pool.h"
+
+class lawson_core
+{
+public:
+    struct point
+    {
+        // Values of the basis functions, and of the function to approximate
+        std::vector<lol::real> basis;
+        lol::real fx, weight, err;
+    };
+
+    lawson_core();
+
+    // All points must have as many basis values; the weights need not sum
+    // to 1, and if they are all zero, the points get equal weights
+    std::vector<point> &points() { return m_points; }
+    std::vector<point> const &points() const { return m_points; }
+
+    // Solve for the coefficients with the current weights, compute the
+    // error at each point, and update the weights
+    void step();
+
+    // Coefficients of the last step, largest error on the points, and a
+    // lower bound on the minimax error on the points
+    std::vector<lol::real> const &get_solution() const { return m_solution; }
+    lol::real get_error() const { return m_error; }
+    lol::real get_lower_bound() const { return m_lower; }
+
+private:
+    int do_job(int i);
+
+    std::vector<point> m_points;
+
+    std::vector<lol::real> m_solution;
+    lol::real m_error, m_lower;
+
+    // Per-chunk normal equations and largest error
+    std::vector<linear_system<lol::real>> m_chunk_matrix;
+    std::vector<std::vector<lol::real>> m_chunk_rhs;
+    std::vector<lol::real> m_chunk_error;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
+
+class lawson_solver
+{
+public:
+    typedef std::function<lol::real(lol::real const &)> function;
+
+    // Approximate f/g, or f if g is empty, on a grid of Chebyshev extrema;
+    // f and g must be safe to call from several threads
+    lawson_solver(function const &f, function const &g, lol::real const &xmin,
+                  lol::real const &xmax, int order, int grid_size = 0);
+
+    // Iterate until the lower and upper bounds on the minimax error are
+    // within “gap” of each other. Returns false if the iteration limit is
+    // hit first.
+    bool solve(double gap, int max_iterations, bool show_progress);
+
+    // Largest weighted error on the grid, and a lower bound on the minimax
+    // error on the grid
+    lol::real get_error() const { return m_core.get_error(); }
+    lol::real get_lower_bound() const { return m_core.get_lower_bound(); }
+
+    // The estimate as Σ a_n·T_n(t) with t = (x - k1) / k2, as in remez_solver
+    std::vector<lol::real> const &get_chebyshev() const { return m_core.get_solution(); }
+
+private:
+    int do_job(int i);
+
+    function m_func, m_weight;
+    int m_order;
+    lol::real m_k1, m_k2;
+
+    // Grid points; the core has T_n(t) and f(x) there, both divided by g(x)
+    std::vector<lol::real> m_ts;
+    lawson_core m_core;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
@@ -14,9 +14,10 @@
 #   include "config.h"
 #endif
 
-#include <float.h>
+#include <algorithm> // std::stable_sort
 #include <iostream>
 #include <iomanip>
+#include <fstream>  // std::ofstream
 #include <optional> // std::optional
 
 #include <lol/utils>
@@ -25,6 +26,18 @@
 
 #include "solver.h"
 #include "expression.h"
+#include "analysis.h"
+#include "bench.h"
+#include "chebyshev.h"
+#include "codegen.h"
+#include "double_double.h"
+#include "fixed.h"
+#include "lawson.h"
+#include "lpsolver.h"
+#include "perf.h"
+#include "scheme.h"
+#include "table.h"
+#include "target.h"
 
 using lol::real;
 
@@ -40,6 +53,9 @@ static std::string footer =
     "Examples:\n"
     "  lolremez --degree 4 --range -1:1 \"atan(exp(1+x))\"\n"
     "  lolremez --degree 4 --range -1:1 \"atan(exp(1+x))\" \"exp(1+x)\"\n"
+    "  lolremez --engine lawson+remez --degree 8 --range 0:4 \"abs(sin(x))\"\n"
+    "  lolremez --one-sided upper --constrain c1=1 --degree 4 --range 0:1 \"exp(x)\"\n"
+    "  lolremez --worst-case --degree 12 --range -0.5:0.5 \"expm1(x)/x\"\n"
     "\n"
     "Tutorial available on https://github.com/samhocevar/lolremez/wiki\n";
 
@@ -102,27 +118,30 @@ static void FAIL(char const *message = nullptr, ...)
 int main(int argc, char **argv)
 {
     std::string str_xmin("-1"), str_xmax("1");
-    enum
-    {
-        mode_float,
-        mode_double,
-        mode_long_double,
-
-        mode_default = mode_double,
-    }
-    mode = mode_default;
+    number_type mode = number_type::float64;
     root_finder rf = root_finder::pegasus;
 
     bool display_hex = false;
+    bool emit_header = false;
     bool show_stats = false;
     bool show_progress = false;
     bool show_debug = false;
     bool no_checks = false;
+    bool plot_all = false;
+    bool double_double = false;
+    bool chebyshev = false;
+    bool search_worst_case = false;
 
     std::string expr;
     std::optional<std::string> error, range;
     std::optional<int> degree;
     std::optional<int> bits;
+    std::optional<int> segments;
+    std::optional<double> ulp_target;
+    std::optional<std::string> simd, scheme_name, cost, bench_file, simd_check, fixed, table_file, engine;
+    std::optional<std::string> one_sided;
+    std::optional<std::vector<std::string>> constraints;
+    std::optional<std::vector<std::string>> plot;
 
     remez_solver solver;
 
@@ -133,11 +152,34 @@ int main(int argc, char **argv)
     // Approximation parameters
     opts.add_option("-d,--degree", degree, "degree of final polynomial")->type_name("<int>");
     opts.add_option("-r,--range", range, "range over which to approximate")->type_name("<xmin>:<xmax>");
+    opts.add_option("--segments", segments, "split the range into this many segments, "
+                                            "each with its own polynomial (requires --table)")->type_name("<int>");
+    opts.add_option("--ulp", ulp_target, "pick the lowest degree (up to --degree) whose total error, "
+                                         "including rounding, is below this many ulps")->type_name("<float>");
+    opts.add_option("--engine", engine, "minimax engine: remez (default), lawson, lawson+remez "
+                                        "to start Remez from the Lawson solution, or lp for a "
+                                        "linear program on an adaptive grid")->type_name("<engine>");
+    opts.add_option("--one-sided", one_sided, "only allow errors on one side: upper for p ≥ f, "
+                                              "lower for p ≤ f (implies --engine lp)")->type_name("<side>");
+    opts.add_option("--constrain", constraints, "constrain a coefficient of p, e.g. c0=1 or "
+                                                "c3>=0 (implies --engine lp)")->type_name("c<n><op><value>");
     // Precision parameters
     opts.add_option("-p,--precision", bits, "floating-point precision (default 512)")->type_name("<int>");
-    opts.add_flag("--float", [&](int64_t) { mode = mode_float; }, "use float type");
-    opts.add_flag("--double", [&](int64_t) { mode = mode_double; }, "use double type");
-    opts.add_flag("--long-double", [&](int64_t) { mode = mode_long_double; }, "use long double type");
+    opts.add_flag("--float", [&](int64_t) { mode = number_type::float32; }, "use float type");
+    opts.add_flag("--double", [&](int64_t) { mode = number_type::float64; }, "use double type");
+    opts.add_flag("--long-double", [&](int64_t) { mode = number_type::long_double; }, "use long double type");
+    opts.add_flag("--half", [&](int64_t) { mode = number_type::float16; }, "use _Float16 type, with float arithmetic");
+    opts.add_flag("--bfloat16", [&](int64_t) { mode = number_type::bfloat16; }, "use __bf16 type, with float arithmetic");
+    opts.add_option("--fixed", fixed, "emit integer-only code for this fixed-point "
+                                      "format, e.g. Q2.30")->type_name("<Qm.n>");
+    opts.add_flag("--chebyshev", chebyshev, "print code in Chebyshev form on the scaled range, "
+                                            "using Clenshaw’s recurrence");
+    opts.add_flag("--double-double", double_double, "store the leading coefficients as double "
+                                                    "pairs and evaluate them in double-double");
+    opts.add_flag("--worst-case", search_worst_case, "search every input for the largest total "
+                                                     "error, by branch and bound (double only)");
+    opts.add_option("--table", table_file, "write the coefficients to this binary file, and print "
+                                           "a loader header instead of code")->type_name("<file>");
     // Root finding algorithms
     opts.add_flag("--bisect", [&](int64_t) { rf = root_finder::bisect; }, "root finding: use bisection");
     opts.add_flag("--regula-falsi", [&](int64_t) { rf = root_finder::regula_falsi; }, "root finding: use regula falsi");
@@ -146,10 +188,27 @@ int main(int argc, char **argv)
     opts.add_flag("--ford", [&](int64_t) { rf = root_finder::ford; }, "root finding: use Ford algorithm");
     // Runtime flags
     opts.add_flag("--hex", display_hex, "print hexadecimal numbers");
+    opts.add_flag("--header", emit_header, "print a C++17 header with constexpr coefficients "
+                                           "and compile-time checks");
+    opts.add_option("--scheme", scheme_name, "evaluation scheme: horner (default), split-horner, "
+                                             "estrin, mixed:<block>, auto")->type_name("<scheme>");
+    opts.add_option("--cost-model", cost, "operation latency and issue ports used to select "
+                                          "the evaluation scheme (default 4:2)")->type_name("<latency>:<ports>");
+    opts.add_option("--simd", simd, "also print an array function using SIMD instructions "
+                                    "(sse2, avx2, avx512, vector)")->type_name("<isa>");
     opts.add_flag("--progress", show_progress, "print progress");
-    opts.add_flag("--stats", show_stats, "print timing statistics");
+    opts.add_flag("--stats", show_stats, "print timing statistics and hardware counters");
     opts.add_flag("--debug", show_debug, "print debug messages");
     opts.add_flag("--no-checks", no_checks, "disable sanity checks");
+    opts.add_option("--bench-emitted", bench_file, "write a benchmark of the generated code to "
+                                                   "this file, then build and run it")->type_name("<file>");
+    opts.add_option("--check-simd", simd_check, "write a program comparing the array function "
+                                                "with the scalar one to this file, then build "
+                                                "and run it for each SIMD instruction set")->type_name("<file>");
+    opts.add_option("--plot-error", plot, "sample the error at N points into a gnuplot or CSV "
+                                          "(.csv) data file, and write a gnuplot script to "
+                                          "<file>.gp")->type_name("<N> <file>")->expected(2);
+    opts.add_flag("--plot-all", plot_all, "also plot the error of intermediate polynomials");
     // Expression to evaluate and optional error expression
     opts.add_option("expression", expr)->type_name("<x-expression>")->required();
     opts.add_option("error", error)->type_name("<x-expression>");
@@ -163,6 +222,167 @@ int main(int argc, char **argv)
         solver.set_order(*degree);
     }
 
+    if (ulp_target && *ulp_target <= 0)
+        FAIL("invalid ulp target: must be positive");
+
+    fixed_format fixed_fmt;
+    if (fixed)
+    {
+        if (!parse_fixed_format(*fixed, fixed_fmt))
+            FAIL("invalid fixed-point format: %s (expected Qm.n with m + n at most 32)",
+                 fixed->c_str());
+        if (ulp_target || simd || scheme_name || emit_header || bench_file)
+            FAIL("--fixed cannot be combined with --ulp, --simd, --scheme, --header "
+                 "or --bench-emitted");
+    }
+
+    if (double_double)
+    {
+        if (mode != number_type::float64)
+            FAIL("--double-double requires double type");
+        if (fixed || ulp_target || simd || scheme_name || emit_header || bench_file)
+            FAIL("--double-double cannot be combined with --fixed, --ulp, --simd, --scheme, "
+                 "--header or --bench-emitted");
+    }
+
+    if (search_worst_case)
+    {
+        if (mode != number_type::float64)
+            FAIL("--worst-case requires double type");
+        if (fixed || double_double || chebyshev || table_file)
+            FAIL("--worst-case cannot be combined with --fixed, --double-double, --chebyshev "
+                 "or --table");
+    }
+
+    if (chebyshev && (fixed || double_double || table_file || ulp_target || simd || scheme_name
+                       || emit_header || bench_file))
+        FAIL("--chebyshev cannot be combined with --fixed, --double-double, --table, --ulp, "
+             "--simd, --scheme, --header or --bench-emitted");
+
+    if (segments && *segments < 1)
+        FAIL("invalid segment count: must be at least 1");
+    if (segments && *segments > 1 && !table_file)
+        FAIL("--segments requires --table");
+    if (table_file)
+    {
+        if (mode == number_type::long_double)
+            FAIL("--table does not support long double type");
+        if (fixed || double_double || ulp_target || simd || scheme_name || emit_header
+             || bench_file || plot)
+            FAIL("--table cannot be combined with --fixed, --double-double, --ulp, --simd, "
+                 "--scheme, --header, --bench-emitted or --plot-error");
+    }
+
+    bool use_lawson = false, use_remez = true, use_lp = false;
+    if (engine)
+    {
+        if (*engine == "lawson")
+            use_lawson = true, use_remez = false;
+        else if (*engine == "lawson+remez")
+            use_lawson = true;
+        else if (*engine == "lp")
+            use_lp = true, use_remez = false;
+        else if (*engine != "remez")
+            FAIL("invalid engine: %s", engine->c_str());
+    }
+
+    // One-sided errors and coefficient constraints need the LP engine
+    lp_solver::side side = lp_solver::side::both;
+    if (one_sided)
+    {
+        if (*one_sided == "upper")
+            side = lp_solver::side::upper;
+        else if (*one_sided == "lower")
+            side = lp_solver::side::lower;
+        else
+            FAIL("invalid side: %s (expected upper or lower)", one_sided->c_str());
+    }
+    if (one_sided || constraints)
+    {
+        if (engine && !use_lp)
+            FAIL("--one-sided and --constrain require --engine lp");
+        if (fixed || table_file || double_double)
+            FAIL("--one-sided and --constrain cannot be combined with --fixed, --table "
+                 "or --double-double");
+        use_lp = true, use_remez = false;
+    }
+    if (one_sided && chebyshev)
+        FAIL("--one-sided cannot be combined with --chebyshev");
+
+    // Error plot: sample count, data file and its format
+    int plot_samples = 0;
+    auto plot_format = remez_solver::format::gnuplot;
+    if (plot)
+    {
+        if (plot->size() != 2 || (plot_samples = atoi((*plot)[0].c_str())) < 2)
+            FAIL("invalid error plot: expected a sample count of at least 2 and a file name");
+        auto const &file = (*plot)[1];
+        if (file.size() >= 4 && file.compare(file.size() - 4, 4, ".csv") == 0)
+            plot_format = remez_solver::format::csv;
+    }
+    else if (plot_all)
+        FAIL("--plot-all requires --plot-error");
+
+    // Evaluation scheme and cost model
+    scheme_kind kind = scheme_kind::horner;
+    int block = 0;
+    bool auto_scheme = false;
+    if (scheme_name)
+    {
+        auto arg = lol::split(*scheme_name, ':');
+        if (*scheme_name == "horner")
+            kind = scheme_kind::horner;
+        else if (*scheme_name == "split-horner")
+            kind = scheme_kind::split_horner;
+        else if (*scheme_name == "estrin")
+            kind = scheme_kind::estrin;
+        else if (*scheme_name == "auto")
+            auto_scheme = true;
+        else if (arg.size() == 2 && arg[0] == "mixed" && (block = atoi(arg[1].c_str())) >= 2)
+            kind = scheme_kind::mixed;
+        else
+            FAIL("invalid evaluation scheme: %s", scheme_name->c_str());
+    }
+
+    cost_model model;
+    if (cost)
+    {
+        auto arg = lol::split(*cost, ':');
+        if (arg.size() != 2 || (model.latency = atoi(arg[0].c_str())) < 1
+             || (model.ports = atoi(arg[1].c_str())) < 1)
+            FAIL("invalid cost model: %s", cost->c_str());
+    }
+
+    simd_isa isa = simd_isa::none;
+    if (simd)
+    {
+        if (*simd == "sse2")
+            isa = simd_isa::sse2;
+        else if (*simd == "avx2")
+            isa = simd_isa::avx2;
+        else if (*simd == "avx512")
+            isa = simd_isa::avx512;
+        else if (*simd == "vector")
+            isa = simd_isa::vector;
+        else
+            FAIL("invalid SIMD instruction set: %s", simd->c_str());
+
+        if (mode != number_type::float32 && mode != number_type::float64)
+            FAIL("SIMD code requires float or double type");
+    }
+
+    if (simd_check)
+    {
+        if (mode != number_type::float32 && mode != number_type::float64)
+            FAIL("SIMD code requires float or double type");
+        if (fixed || double_double || chebyshev || table_file)
+            FAIL("--check-simd cannot be combined with --fixed, --double-double, --chebyshev "
+                 "or --table");
+    }
+
+    if (emit_header && get_target_info(mode).compute != mode)
+        FAIL("--header requires float, double or long double type");
+
     if (range)
     {
         auto arg = lol::split(*range, ':');
@@ -199,8 +419,42 @@ int main(int argc, char **argv)
         FAIL("invalid range: xmin >= xmax");
     solver.set_range(xmin, xmax);
 
+    // Coefficient constraints: “c”, the power, the relation, then a constant
+    struct coeff_constraint { int power; lp_solver::relation rel; real value; };
+    std::vector<coeff_constraint> coeff_constraints;
+    for (auto const &spec : constraints ? *constraints : std::vector<std::string>())
+    {
+        // Powers of up to 9 digits, which always fit in an int
+        size_t const op = spec.find_first_of("<>=");
+        if (spec[0] != 'c' || op == std::string::npos || op < 2 || op > 10
+             || spec.find_first_not_of("0123456789", 1) != op)
+            FAIL("invalid constraint syntax: %s", spec.c_str());
+        int const power = std::stoi(spec.substr(1, op - 1));
+
+        auto rel = lp_solver::relation::equal;
+        size_t len = 1;
+        if (spec.compare(op, 2, "<=") == 0)
+            rel = lp_solver::relation::less_equal, len = 2;
+        else if (spec.compare(op, 2, ">=") == 0)
+            rel = lp_solver::relation::greater_equal, len = 2;
+        else if (spec[op] != '=')
+            FAIL("invalid constraint syntax: %s", spec.c_str());
+
+        if (!ex.parse(spec.substr(op + len)))
+            FAIL("invalid constraint syntax: %s", spec.c_str());
+        if (!ex.is_constant())
+            FAIL("invalid constraint: value must be constant");
+        coeff_constraints.push_back(coeff_constraint { power, rel, ex.eval(real::R_0()) });
+
+        // The constant coefficient is what keeps p on one side of f
+        if (one_sided && power == 0)
+            FAIL("--one-sided cannot be combined with a constraint on c0");
+    }
+
     if (!ex.parse(expr))
         FAIL("invalid function: %s", expr.c_str());
+    if (search_worst_case && !can_find_worst_case(ex))
+        FAIL("--worst-case does not support atan2, min, max, %% or fmod, or conversions");
 
     // Special case: if the function is constant, evaluate it immediately
     if (ex.is_constant())
@@ -211,6 +465,8 @@ int main(int argc, char **argv)
     }
 
     solver.set_func(ex);
+    expression const func = ex;
+    std::function<real(real const &)> weight;
 
     if (error)
     {
@@ -218,55 +474,244 @@ int main(int argc, char **argv)
             FAIL("invalid weight function: %s", error->c_str());
 
         solver.set_weight(ex);
+        weight = [ex](real const &x) { return ex.eval(x); };
     }
 
-    // https://en.wikipedia.org/wiki/Floating-point_arithmetic#Internal_representation
-    int digits = mode == mode_float ? FLT_DIG + 2 :
-                 mode == mode_double ? DBL_DIG + 2 : LDBL_DIG + 2;
+    auto const &info = get_target_info(mode);
+    int digits = info.digits;
+    // Extended-accuracy kernels need a more accurate polynomial
+    if (double_double)
+        digits *= 2;
     solver.set_digits(digits);
     solver.set_root_finder(rf);
 
     solver.show_stats = show_stats;
     solver.show_debug = show_debug;
 
+    // Counters may not be permitted; the phases are still timed then
+    std::string perf_error;
+    if (show_stats && !perf_counters::start(perf_error))
+        std::cout << " -:- hardware counters unavailable: " << perf_error << '\n';
+
     if (!no_checks && !solver.check_sanity())
         return EXIT_FAILURE;
 
     // Solve polynomial
-    solver.do_init();
-    for (int iteration = 0; ; ++iteration)
+    bool lawson_converged = true, lp_converged = true;
+    auto solve = [&]()
     {
-        fprintf(stderr, "Iteration: %d\r", iteration);
-        fflush(stderr); // Required on Windows because stderr is buffered.
-        if (!solver.do_step())
-            break;
+        // When searching for a degree, each solve overwrites the plot, so
+        // that it describes the final polynomial.
+        std::ofstream plot_file;
+        int blocks = 0;
+        if (plot && !(plot_file.open((*plot)[1]), plot_file))
+            FAIL("cannot write error plot to %s", (*plot)[1].c_str());
+
+        // Lawson iterations, either to the end, or until the error is
+        // known well enough for Remez to take over
+        bool warm_start = false;
+        if (use_lawson)
+        {
+            lawson_solver lawson([&func](real const &x) { return func.eval(x); }, weight,
+                                 solver.get_xmin(), solver.get_xmax(), solver.get_order());
+            lawson_converged = lawson.solve(use_remez ? 0.05 : 0.001, 5000, show_progress);
+            warm_start = solver.do_init(lawson.get_chebyshev());
+        }
+        if (use_lp)
+        {
+            lp_solver lp([&func](real const &x) { return func.eval(x); }, weight,
+                         solver.get_xmin(), solver.get_xmax(), solver.get_order());
+            lp.set_side(side);
+            for (auto const &c : coeff_constraints)
+                lp.add_constraint(c.power, c.rel, c.value);
+            if (!lp.solve(0.001, 1000, show_progress))
+                FAIL(lp.limit_reached() ? "the linear program did not converge"
+                                        : "the constraints cannot be satisfied");
+            lp_converged = !lp.limit_reached();
+            solver.do_init(lp.get_chebyshev());
+        }
+        if (use_remez && !warm_start)
+            solver.do_init();
 
-        if (show_progress)
+        for (int iteration = 0; use_remez; ++iteration)
         {
-            auto p = solver.get_estimate();
-            for (int j = 0; j < p.degree() + 1; j++)
+            fprintf(stderr, "Iteration: %d\r", iteration);
+            fflush(stderr); // Required on Windows because stderr is buffered.
+            if (!solver.do_step())
+                break;
+
+            if (plot_all)
+                solver.plot_error(plot_file, plot_format, plot_samples, blocks++);
+
+            if (show_progress)
             {
-                if (j > 0 && p[j] >= real::R_0())
-                    std::cout << '+';
-                std::cout << std::setprecision(digits) << p[j];
-                if (j > 1)
-                    std::cout << "*x**" << j;
-                else if (j == 1)
-                    std::cout << "*x";
+                auto p = solver.get_estimate();
+                for (int j = 0; j < p.degree() + 1; j++)
+                {
+                    if (j > 0 && p[j] >= real::R_0())
+                        std::cout << '+';
+                    std::cout << std::setprecision(digits) << p[j];
+                    if (j > 1)
+                        std::cout << "*x**" << j;
+                    else if (j == 1)
+                        std::cout << "*x";
+                }
+                std::cout << '\n';
+                fflush(stdout);
             }
-            std::cout << '\n';
-            fflush(stdout);
         }
+
+        if (plot)
+        {
+            solver.plot_error(plot_file, plot_format, plot_samples, blocks++);
+            std::ofstream script((*plot)[1] + ".gp");
+            solver.plot_script(script, plot_format, (*plot)[1], blocks);
+        }
+
+        return solver.get_estimate();
+    };
+
+    if (table_file)
+    {
+        // Piecewise approximation: each segment’s polynomial is rewritten
+        // in terms of the distance to the segment centre, which keeps the
+        // coefficients well conditioned far from zero.
+        int const count = segments ? *segments : 1;
+        std::vector<table_segment> list;
+        real max_error = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            real const lo = xmin + (xmax - xmin) * real(k) / real(count);
+            real const hi = k + 1 == count ? xmax : xmin + (xmax - xmin) * real(k + 1) / real(count);
+            fprintf(stderr, "Segment: %d/%d\n", k + 1, count);
+            solver.set_range(lo, hi);
+            auto const q = solve();
+            real const center = round_to((lo + hi) / 2, info.compute);
+            list.push_back(table_segment { lo, hi, center,
+                                           q.eval(lol::polynomial<real>({ center, real::R_1() })) });
+            max_error = max(max_error, solver.get_error());
+        }
+
+        if (show_stats)
+            perf_counters::report(std::cout);
+
+        if (!write_table(*table_file, mode, xmin, xmax, list))
+            FAIL("cannot write table to %s", table_file->c_str());
+
+        std::cout << "// " << count << " segments of degree " << list[0].p.degree()
+                  << " approximations of f(x) = " << expr << '\n';
+        if (error)
+            std::cout << "// with weight function g(x) = " << *error << '\n';
+        std::cout << "// on interval [ " << str_xmin << ", " << str_xmax << " ]\n";
+        std::cout << "// Estimated max error: " << std::setprecision(digits) << max_error << '\n';
+        std::cout << "// Coefficients in " << *table_file << '\n';
+        emit_loader(std::cout, mode, "f");
+        return 0;
     }
 
+    lol::polynomial<real> p;
+    error_budget budget;
+    eval_scheme scheme = eval_scheme::horner(0);
+
+    // Select the evaluation scheme for p and verify its error. Candidates
+    // are tried from fastest to slowest according to the cost model, and
+    // the first one that meets the ulp target (if any) wins. Returns false
+    // if no scheme meets the target.
+    auto select_scheme = [&]() -> bool
+    {
+        int const d = p.degree();
+        std::vector<eval_scheme> list;
+        if (auto_scheme)
+            list = eval_scheme::candidates(d);
+        else
+            list.push_back(kind == scheme_kind::split_horner ? eval_scheme::split_horner(d)
+                         : kind == scheme_kind::estrin ? eval_scheme::estrin(d)
+                         : kind == scheme_kind::mixed ? eval_scheme::mixed(d, block)
+                         : eval_scheme::horner(d));
+
+        std::stable_sort(list.begin(), list.end(),
+            [&](eval_scheme const &a, eval_scheme const &b)
+            {
+                int ta = a.schedule(model), tb = b.schedule(model);
+                return ta < tb || (ta == tb && a.op_count() < b.op_count());
+            });
+
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            auto b = compute_error_budget(p, list[i], func, xmin, xmax, mode);
+            if (i == 0 || b.total < budget.total)
+            {
+                scheme = list[i];
+                budget = b;
+            }
+
+            if (!ulp_target || b.total <= *ulp_target)
+            {
+                scheme = list[i];
+                budget = b;
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    if (ulp_target)
+    {
+        // Increase the degree until the total error budget, including the
+        // rounding errors of the generated code, meets the target.
+        int const max_degree = degree ? *degree : 40;
+        for (int d = 1; ; ++d)
+        {
+            solver.set_order(d);
+            p = solve();
+            bool const met = select_scheme();
+            if (show_progress)
+                std::cout << "degree " << d << ": total error " << budget.total << " ulp\n";
+            if (met)
+                break;
+            if (d >= max_degree)
+                FAIL("cannot reach %g ulp with a degree up to %d (best: %g ulp)",
+                     *ulp_target, max_degree, budget.total);
+        }
+    }
+    else
+    {
+        p = solve();
+        if (!fixed && !double_double && !chebyshev)
+            select_scheme();
+    }
+
+    // The solver only keeps p on one side of f with exact coefficients and
+    // arithmetic; make room for the rounding errors of the generated code.
+    if (one_sided)
+    {
+        int const wrong = make_one_sided(p, scheme, func, xmin, xmax, mode,
+                                         side == lp_solver::side::upper);
+        if (wrong)
+            FAIL("the generated code is on the wrong side of f for %d inputs", wrong);
+        budget = compute_error_budget(p, scheme, func, xmin, xmax, mode);
+    }
+
+    if (show_stats)
+        perf_counters::report(std::cout);
+
     // Print final estimate
-    auto p = solver.get_estimate();
-    char const *type = mode == mode_float ? "float" :
-                       mode == mode_double ? "double" : "long double";
+    char const *type = info.name;
     std::cout << "// Degree " << p.degree() << " approximation of f(x) = " << expr << '\n';
     if (error)
         std::cout << "// with weight function g(x) = " << *error << '\n';
     std::cout << "// on interval [ " << str_xmin << ", " << str_xmax << " ]\n";
+    if (one_sided || constraints)
+    {
+        std::cout << "// subject to";
+        if (one_sided)
+            std::cout << (side == lp_solver::side::upper ? " p(x) >= f(x)" : " p(x) <= f(x)")
+                      << (constraints ? "," : "");
+        for (size_t i = 0; constraints && i < constraints->size(); ++i)
+            std::cout << ' ' << (*constraints)[i] << (i + 1 < constraints->size() ? "," : "");
+        std::cout << '\n';
+    }
 
     // Print expression in Horner form
     std::cout << std::setprecision(digits);
@@ -279,28 +724,187 @@ int main(int argc, char **argv)
                   << (p[j] > real::R_0() ? "+" : "") << p[j];
     std::cout << '\n';
     std::cout << "// Estimated max error: " << solver.get_error() << '\n';
+    if (!use_remez && !lawson_converged)
+        std::cout << "// Warning: Lawson iteration limit reached\n";
+    if (use_lp && !lp_converged)
+        std::cout << "// Warning: simplex iteration limit reached\n";
+    std::cout << std::setprecision(3);
 
-    // Print C/C++ function
-    std::cout << std::setprecision(digits);
-    std::cout << type << " f(" << type << " x)\n{\n";
-    if (display_hex)
-        std::cout << std::hexfloat;
-    for (int j = p.degree(); j >= 0; --j)
-    {
-        char const *a = j ? "u = u * x +" : "return u * x +";
-        if (j == p.degree())
-            std::cout << "    " << type << " u = ";
+    if (fixed)
+    {
+        // Quantise for the error against f, then check every input
+        fixed_horner fh;
+        if (!fh.init(p, fixed_fmt, xmin, xmax))
+            return EXIT_FAILURE;
+        fprintf(stderr, "Quantising…\r");
+        fflush(stderr);
+        fh.optimize(func);
+        fprintf(stderr, "Verifying…\r");
+        fflush(stderr);
+        auto const report = fh.verify(func);
+        if (report.overflow)
+            FAIL("fixed-point evaluation overflows in %s", fixed->c_str());
+
+        // Against the polynomial, only a bound of the error against f is
+        // known, and only when there is no weight function
+        std::cout << "// Fixed-point error in " << *fixed << " LSBs: " << report.max_error
+                  << (report.against_func ? " against f" : " against the polynomial")
+                  << " (all " << report.count << " inputs checked)";
+        if (!report.against_func && !error)
+            std::cout << ", at most " << report.max_error + double(ldexp(solver.get_error(), fixed_fmt.n))
+                      << " against f";
+        std::cout << '\n';
+        fh.emit(std::cout, "f");
+        return 0;
+    }
+
+    if (chebyshev)
+    {
+        chebyshev_form cf(solver.get_chebyshev(), solver.get_k1(), solver.get_k2(), mode);
+        std::cout << std::setprecision(digits) << "// Chebyshev form on t = (x - " << solver.get_k1()
+                  << ") / " << solver.get_k2() << std::setprecision(3) << ", observed error in "
+                  << type << " ulps: " << cf.observed_error(func, xmin, xmax) << '\n';
+        cf.emit(std::cout, "f", display_hex);
+        return 0;
+    }
+
+    if (double_double)
+    {
+        // Choose how many steps need double-double, then check the code
+        // as it will run against f
+        dd_horner dd(p);
+        dd.select(func, xmin, xmax);
+        auto const report = dd.verify(func, xmin, xmax);
+
+        std::cout << "// Double-double for the " << dd.steps() << " lowest-degree coefficients; "
+                  << "error in double ulps: approximation " << report.approximation
+                  << ", evaluation " << report.evaluation << ", total " << report.total
+                  << " (observed " << report.observed << ")\n";
+        if (report.observed > report.total)
+            std::cout << "// Warning: observed error exceeds the bound; "
+                         "is the compiler contracting floating-point operations?\n";
+        dd.emit(std::cout, "f", display_hex);
+        return 0;
+    }
+
+    std::cout << "// Error budget in " << type << " ulps: approximation " << budget.approximation
+              << ", rounding " << budget.rounding << ", total " << budget.total
+              << " at x = " << std::hexfloat << double(budget.worst_x) << std::defaultfloat
+              << std::setprecision(3) << " (observed " << budget.observed;
+    if (budget.exhaustive)
+        std::cout << ", all " << budget.count << " inputs checked";
+    std::cout << ")\n";
+    std::cout << "// Evaluation scheme: " << scheme.name() << ", " << scheme.op_count()
+              << " operations, estimated " << scheme.schedule(model) << " cycles ("
+              << model.latency << "-cycle latency, " << model.ports << " ports)\n";
+
+    if (search_worst_case)
+    {
+        fprintf(stderr, "Searching for the worst case…\r");
+        fflush(stderr);
+        worst_case wc;
+        find_worst_case(p, scheme, func, xmin, xmax, wc);
+        std::cout << "// Worst case: total error " << wc.total << " ulps at x = " << std::hexfloat
+                  << double(wc.x) << std::defaultfloat << std::setprecision(3)
+                  << " (observed " << wc.observed << ")\n";
+        if (wc.proven)
+            std::cout << "// No input exceeds " << wc.bound << " ulps: ";
         else
-            std::cout << "    " << a << " ";
-        switch (mode)
+            std::cout << "// Search stopped, inputs may reach " << wc.bound << " ulps: ";
+        std::cout << wc.intervals << " subintervals bounded, " << wc.count
+                  << " inputs checked, largest observed error " << wc.max_observed << '\n';
+    }
+
+    // Benchmark the generated code; with automatic scheme selection, all
+    // candidates are compared.
+    if (bench_file)
+    {
+        std::vector<code_generator> kernels;
+        for (auto const &s : auto_scheme ? eval_scheme::candidates(p.degree())
+                                         : std::vector<eval_scheme> { scheme })
+        {
+            kernels.push_back(code_generator(p, mode, s));
+            kernels.back().set_name("f" + std::to_string(kernels.size() - 1));
+        }
+
+        std::vector<bench_result> results;
+        std::string compiler;
+        fprintf(stderr, "Benchmarking…\r");
+        fflush(stderr);
+        if (run_benchmark(*bench_file, mode, xmin, xmax, kernels, results, compiler))
         {
-            case mode_float: std::cout << float(p[j]) << 'f'; break;
-            case mode_double: std::cout << double(p[j]); break;
-            case mode_long_double: std::cout << (long double)p[j] << 'l'; break;
+            std::cout << "// Benchmark (" << compiler << "), ns per call when latency-bound"
+                         " and throughput-bound:\n";
+            for (auto const &r : results)
+                std::cout << "//   " << r.name << ": " << r.latency << ", " << r.throughput << '\n';
         }
-        std::cout << ";\n";
+        else
+            std::cout << "// Benchmark: could not build or run " << *bench_file
+                      << " using " << compiler << '\n';
+    }
+
+    // Check the array function against the scalar one, bit for bit
+    if (simd_check)
+    {
+        code_generator kernel(p, mode, scheme);
+        std::vector<simd_check_result> results;
+        std::string compiler;
+        fprintf(stderr, "Checking SIMD code…\r");
+        fflush(stderr);
+        if (!check_simd(*simd_check, mode, xmin, xmax, kernel, results, compiler))
+            FAIL("cannot write SIMD check to %s", simd_check->c_str());
+
+        std::cout << "// SIMD check (" << compiler << "):";
+        for (auto const &r : results)
+        {
+            std::cout << (&r == &results[0] ? " " : ", ") << r.name << ' ';
+            switch (r.status)
+            {
+            case simd_check_result::status::match:
+                std::cout << "matches";
+                break;
+            case simd_check_result::status::mismatch:
+                std::cout << "differs at x = " << r.x;
+                break;
+            case simd_check_result::status::unsupported:
+                std::cout << "not supported by this CPU";
+                break;
+            case simd_check_result::status::failed:
+                std::cout << "could not build or run";
+                break;
+            }
+        }
+        std::cout << '\n';
+    }
+
+    // Print C/C++ function
+    code_generator gen(p, mode, scheme);
+    gen.set_hex(display_hex);
+    if (emit_header)
+    {
+        // Check the generated code at both ends and in the middle of the
+        // range, within the error budget plus the rounding of the
+        // reference value itself.
+        std::vector<header_check> checks;
+        for (auto const &x0 : { xmin, (xmin + xmax) / 2, xmax })
+        {
+            real const x = round_to(x0, mode);
+            real const value = func.eval(x);
+            real const tolerance = error_bound_at(p, scheme, func, x, mode) + ulp(value, mode);
+            checks.push_back(header_check { x, value, tolerance });
+        }
+
+        gen.set_inline(true);
+        gen.emit_header(std::cout, solver.get_error(), budget.total, checks);
+    }
+    else
+        gen.emit_scalar(std::cout);
+
+    if (isa != simd_isa::none)
+    {
+        std::cout << '\n';
+        gen.emit_array(std::cout, isa);
     }
-    std::cout << "}\n";
 
     return 0;
 }
@@ -14,171 +14,532 @@
 #   include "config.h"
 #endif
 
+#include <algorithm> // std::max
 #include <iostream>
 #include <iomanip>
-#include <array>
+#include <optional>  // std::optional
 
+#include <lol/utils>
+#include <lol/cli>
 #include <lol/real>
 
-#include "matrix.h"
-
-using namespace lol;
+#include "chebyshev2d.h"
+#include "codegen.h"
+#include "cross.h"
+#include "expression.h"
+#include "minimax2d.h"
+#include "solver.h"
+#include "target.h"
+#include "ttcross.h"
+
+using lol::real;
+
+static std::string footer =
+    "\n"
+    "Examples:\n"
+    "  lolremez2d --degree 8 --range 0:1 \"exp(x*y)\"\n"
+    "  lolremez2d --float --range 0:1 --yrange 1:2 \"log(x+y)\"\n"
+    "  lolremez2d --total-degree 4 --range 0:1 \"x*y/(1+x+y)\"\n"
+    "  lolremez2d --quick --degree 12 --range 0:1 \"sin(x+y*y)\"\n"
+    "  lolremez2d --degree 6 --range 0:1 \"exp(-x*y*z)\"\n"
+    "\n"
+    "Written by Sam Hocevar. Report bugs to <sam@hocevar.net> or to the\n"
+    "issue page: https://github.com/samhocevar/lolremez/issues\n";
+
+static void FAIL(char const *message = nullptr, ...)
+{
+    if (message)
+    {
+        printf("Error: ");
+        va_list ap;
+        va_start(ap, message);
+        vfprintf(stdout, message, ap);
+        va_end(ap);
+        printf("\n");
+    }
+    printf("Try 'lolremez2d --help' for more information.\n");
+    exit(EXIT_FAILURE);
+}
 
-// FIXME: use rvec2 when possible
-struct real2
+// Parse a <min>:<max> range of constant expressions
+static bool parse_range(std::string const &str, real &min, real &max)
 {
-    real x, y;
-};
+    auto arg = lol::split(str, ':');
+    expression ex;
+    if (arg.size() != 2)
+        return false;
+    if (!ex.parse(arg[0]) || !ex.is_constant())
+        return false;
+    min = ex.eval(real::R_0());
+    if (!ex.parse(arg[1]) || !ex.is_constant())
+        return false;
+    max = ex.eval(real::R_0());
+    return min < max;
+}
+
+// Maximum number of Remez iterations for one factor; nearly polynomial
+// factors may never meet the stopping test
+static int const max_factor_iterations = 200;
 
-real f(real const &x, real const &y)
+// Approximate a univariate factor with a minimax polynomial. Factors are
+// fitted one after the other: the solver already spreads each step over
+// the worker pool, and its idle workers help search each bracket. Returns
+// false if the Remez iteration limit was reached.
+static bool fit_factor(std::function<real(real const &)> const &fn, real const &a, real const &b,
+                       int degree, int digits, lol::polynomial<real> &p, real &error)
 {
-    static real const one = real::R_1();
+    // The Remez exchange needs an error that changes sign, so when fn is
+    // already a polynomial of that degree, as are the constant factors of
+    // most tensor trains, use the interpolant through Chebyshev nodes.
+    std::vector<real> xs, ys;
+    for (int i = 0; i <= degree; ++i)
+    {
+        xs.push_back((a + b + (b - a) * cos(real::R_PI() * (2 * i + 1) / (2 * degree + 2))) / 2);
+        ys.push_back(fn(xs.back()));
+    }
+
+    lol::polynomial<real> q;
+    for (int i = 0; i <= degree; ++i)
+    {
+        lol::polynomial<real> l({ ys[i] });
+        for (int j = 0; j <= degree; ++j)
+            if (j != i)
+                l = l * lol::polynomial<real>({ -xs[j] / (xs[i] - xs[j]),
+                                                real::R_1() / (xs[i] - xs[j]) });
+        q += l;
+    }
 
-    //return exp(sin(x+x+x)+cos(y-one/4));
-    real f = (x + one) / 2;
-    real d = (y + one) / 2;
-    return sin((one - f) * acos(d)) / sqrt(one - d * d);
+    real diff(0), threshold(0);
+    for (int i = 0; i <= degree + 1; ++i)
+    {
+        real const x = a + (b - a) * real(i) / real(degree + 1);
+        real const y = fn(x);
+        diff = max(diff, fabs(y - q.eval(x)));
+        threshold = max(threshold, fabs(y));
+    }
+    for (int i = 0; i < digits; ++i)
+        threshold /= real(10);
+
+    if (diff <= threshold)
+    {
+        // Drop the coefficients that are only rounding noise
+        real const scale = max(real::R_1(), max(fabs(a), fabs(b)));
+        real unit = threshold;
+        p = lol::polynomial<real>();
+        for (int i = 0; i <= q.degree(); ++i, unit /= scale)
+            if (fabs(q[i]) > unit)
+                p.set(i, q[i]);
+        error = diff;
+        return true;
+    }
+
+    remez_solver solver;
+    solver.set_order(degree);
+    solver.set_digits(digits);
+    solver.set_range(a, b);
+    solver.set_func(fn);
+    solver.do_init();
+    int iteration = 0;
+    while (iteration < max_factor_iterations && solver.do_step())
+        ++iteration;
+    p = solver.get_estimate();
+    error = solver.get_error();
+    return iteration < max_factor_iterations;
 }
 
-struct solver
+// Approximate f(x,y) by a sum of products of univariate functions, add
+// terms until the error between grid points meets the tolerance, then
+// replace each univariate function with a polynomial. Functions of three
+// or four variables use a tensor train instead, which is also a sum of
+// products of univariate functions, with fewer terms to store.
+int main(int argc, char **argv)
 {
-    solver(int grid_size, int iters)
-      : m_grid_size(grid_size),
-        m_iters(iters),
-        m_ek(iters, iters)
+    std::string str_xrange("-1:1");
+    number_type mode = number_type::float64;
+
+    int degree = 8;
+    int max_rank = 16;
+    bool display_hex = false;
+    bool show_progress = false;
+    bool quick = false;
+
+    std::string expr;
+    std::optional<std::string> range, yrange, zrange, wrange;
+    std::optional<double> tolerance;
+    std::optional<int> bits, grid, total_degree;
+
+    lol::cli::app opts("lolremez2d");
+    opts.set_version_flag("-V,--version", PACKAGE_VERSION);
+    opts.footer(footer);
+
+    opts.add_option("-d,--degree", degree, "degree of the univariate polynomials "
+                                           "(default 8)")->type_name("<int>");
+    opts.add_option("-r,--range", range, "x range over which to approximate")->type_name("<xmin>:<xmax>");
+    opts.add_option("--yrange", yrange, "y range over which to approximate (default: same "
+                                        "as x)")->type_name("<ymin>:<ymax>");
+    opts.add_option("--zrange", zrange, "z range over which to approximate (default: same "
+                                        "as x)")->type_name("<zmin>:<zmax>");
+    opts.add_option("--wrange", wrange, "w range over which to approximate (default: same "
+                                        "as x)")->type_name("<wmin>:<wmax>");
+    opts.add_option("--tolerance", tolerance, "add terms until the error is below this value "
+                                              "(default: one ulp of max |f|)")->type_name("<float>");
+    opts.add_option("--rank", max_rank, "maximum number of terms, or tensor-train rank "
+                                        "(default 16)")->type_name("<int>");
+    opts.add_option("--total-degree", total_degree, "find a minimax polynomial in x and y of this "
+                                                    "total degree instead")->type_name("<int>");
+    opts.add_flag("--quick", quick, "interpolate on a tensor-product Chebyshev grid, and "
+                                    "truncate to the degree in x and y, or to the total degree");
+    opts.add_option("--grid", grid, "sampling grid size (default 64, 4 × (total degree + 1), "
+                                    "or 32 with three or more variables)")->type_name("<int>");
+    opts.add_option("-p,--precision", bits, "floating-point precision (default 512)")->type_name("<int>");
+    opts.add_flag("--float", [&](int64_t) { mode = number_type::float32; }, "use float type");
+    opts.add_flag("--double", [&](int64_t) { mode = number_type::float64; }, "use double type");
+    opts.add_flag("--long-double", [&](int64_t) { mode = number_type::long_double; }, "use long double type");
+    opts.add_flag("--hex", display_hex, "print hexadecimal numbers");
+    opts.add_flag("--progress", show_progress, "print progress");
+    opts.add_option("expression", expr)->type_name("<expression>")->required();
+
+    CLI11_PARSE(opts, argc, argv);
+
+    if (degree < 1)
+        FAIL("invalid degree: must be at least 1");
+    if (max_rank < 1)
+        FAIL("invalid rank: must be at least 1");
+    if (total_degree && *total_degree < 1)
+        FAIL("invalid total degree: must be at least 1");
+    if (tolerance && *tolerance <= 0)
+        FAIL("invalid tolerance: must be positive");
+
+    if (bits)
     {
-        for (int i = 0; i <= grid_size; ++i)
-            m_coeff.push_back(cheb(i, grid_size));
+        if (*bits < 32 || *bits > 65535)
+            FAIL("invalid precision %d", *bits);
+        real::global_bigit_count((*bits + 31) / 32);
     }
 
-    void step()
+    real xmin, xmax, ymin, ymax;
+    if (range)
+        str_xrange = *range;
+    if (!parse_range(str_xrange, xmin, xmax))
+        FAIL("invalid range: %s", str_xrange.c_str());
+    std::string const str_yrange = yrange ? *yrange : str_xrange;
+    if (!parse_range(str_yrange, ymin, ymax))
+        FAIL("invalid y range: %s", str_yrange.c_str());
+
+    expression func;
+    if (!func.parse(expr))
+        FAIL("invalid function: %s", expr.c_str());
+
+    int const variables = std::max(func.variables(), 2);
+    if (variables > 2 && (quick || total_degree))
+        FAIL("--quick and --total-degree only support functions of x and y");
+
+    int const grid_size = grid ? *grid : total_degree ? 4 * (*total_degree + 1)
+                        : variables > 2 ? 32 : 64;
+    if (grid_size < 2)
+        FAIL("invalid grid size: must be at least 2");
+
+    auto const f = [&func](real const &x, real const &y) { return func.eval(x, y); };
+    auto const &info = get_target_info(mode);
+
+    // Tensor-product Chebyshev interpolation, either as the result, or as
+    // the starting point of the minimax engine
+    if (quick || total_degree)
     {
-        /* Find a new good pivot */
-        real2 best_pivot { 0, 0 };
-        real best_val(0);
+        int const d = total_degree ? *total_degree : degree;
+        chebyshev2d cheb(f, xmin, xmax, ymin, ymax, d, d);
+        cheb.truncate(total_degree ? *total_degree : -1);
 
-        for (auto const &y : m_coeff)
-        for (auto const &x : m_coeff)
+        if (quick)
         {
-            real res = eval_ek(x, y);
-            if (fabs(res) >= fabs(best_val))
-            {
-                best_pivot = { x, y };
-                best_val = res;
-            }
+            real const check = cheb.check_error(2 * grid_size);
+
+            std::cout << "// Tensor-product Chebyshev approximation of f(x,y) = " << expr << '\n';
+            std::cout << "// on [ " << str_xrange << " ] × [ " << str_yrange << " ]";
+            if (total_degree)
+                std::cout << ", total degree " << d << '\n';
+            else
+                std::cout << ", degree " << d << " in x and y\n";
+            std::cout << std::setprecision(3);
+            std::cout << "// Max error on a " << (2 * grid_size + 1) << "×" << (2 * grid_size + 1)
+                      << " grid: " << check << '\n';
+            emit_horner2d(std::cout, cheb.get_estimate(), mode, "f", display_hex);
+            return EXIT_SUCCESS;
         }
 
-        /* Compute d_k = 1/e_{k-1}(x,y) */
-        real dk = real::R_1() / best_val;
-
-        /* Compute e_{k-1}(x_k,y) as a vector of f(x_i,y) components
-         * and e_{k-1}(x,y_k) as a vector of f(x,y_i) components */
-        std::vector<real> ek_x, ek_y;
-        ek_x.resize(m_pivots.size() + 1);
-        ek_y.resize(m_pivots.size() + 1);
-        for (size_t i = 0; i < m_pivots.size(); ++i)
-            for (size_t j = 0; j < m_pivots.size(); ++j)
-                if (m_ek[j][i])
-                {
-                    ek_x[j] += m_ek[j][i] * eval_f(m_pivots[i].x, best_pivot.y);
-                    ek_y[i] += m_ek[j][i] * eval_f(best_pivot.x, m_pivots[j].y);
-                }
-        ek_x[m_pivots.size()] = 1; /* implicit f */
-        ek_y[m_pivots.size()] = 1; /* implicit f */
-
-        /* Compute new fk */
-        for (size_t i = 0; i < m_pivots.size() + 1; ++i)
-            for (size_t j = 0; j < m_pivots.size() + 1; ++j)
-                m_ek[j][i] -= ek_y[i] * ek_x[j] * dk;
-
-        /* Register new pivot */
-        m_pivots.push_back(best_pivot);
+        // Lawson iterations until the error is known within 0.5%, with
+        // initial weights given by the error of the interpolant
+        minimax2d_solver solver(f, xmin, xmax, ymin, ymax, *total_degree, grid_size);
+        solver.set_seed([&cheb](real const &x, real const &y) { return cheb.eval(x, y); });
+        bool const converged = solver.solve(0.005, 1000, 8, show_progress);
+        real const check = solver.check_error();
+
+        std::cout << "// Total degree " << *total_degree << " approximation of f(x,y) = "
+                  << expr << '\n';
+        std::cout << "// on [ " << str_xrange << " ] × [ " << str_yrange << " ]\n";
+        std::cout << std::setprecision(info.digits);
+        std::cout << "// Estimated max error: " << solver.get_error() << '\n';
+        std::cout << std::setprecision(3);
+        std::cout << "// Minimax error at least " << solver.get_lower_bound()
+                  << ", max error between grid points " << check << '\n';
+        if (!converged)
+            std::cout << "// Warning: iteration limit reached\n";
+        emit_horner2d(std::cout, solver.get_estimate(), mode, "f", display_hex);
+        return EXIT_SUCCESS;
     }
 
-    real eval_f(real const &x, real const &y)
+    if (variables > 2)
     {
-        static std::vector<std::array<real, 3>> cache;
+        static char const *names[] = { "x", "y", "z", "w" };
+
+        std::vector<std::string> str_ranges { str_xrange, str_yrange,
+                                              zrange ? *zrange : str_xrange,
+                                              wrange ? *wrange : str_xrange };
+        std::vector<real> mins { xmin, ymin, real(), real() };
+        std::vector<real> maxs { xmax, ymax, real(), real() };
+        for (int k = 2; k < variables; ++k)
+            if (!parse_range(str_ranges[k], mins[k], maxs[k]))
+                FAIL("invalid %s range: %s", names[k], str_ranges[k].c_str());
+        str_ranges.resize(variables);
+        mins.resize(variables);
+        maxs.resize(variables);
+
+        auto const fn = [&func](std::vector<real> const &xs)
+        {
+            return func.eval(xs[0], xs[1], xs[2], xs.size() > 3 ? xs[3] : real::R_0());
+        };
 
-        for (auto const &v : cache)
-            if (x == v[0] && y == v[1])
-                return v[2];
+        // Sweep until no bond needs another pivot
+        tt_cross_solver tt(fn, mins, maxs, grid_size, max_rank);
+        if (tt.grid_error().is_zero())
+            FAIL("function vanishes on the initial search lines");
 
-        cache.push_back({x, y, f(x, y)});
-        return cache.back()[2];
-    }
+        real const target = tolerance ? real(*tolerance) : ulp(tt.grid_error(), mode);
 
-    real eval_ek(real const &x, real const &y)
-    {
-        /* Evaluate e_k at x,y: first, the implicit f part */
-        real ret = eval_f(x, y);
+        for (int n = 0; tt.sweep(target) > 0; ++n)
+        {
+            if (show_progress)
+            {
+                std::cout << "sweep " << n << ": ranks";
+                for (int k = 0; k < variables - 1; ++k)
+                    std::cout << ' ' << tt.rank(k);
+                std::cout << ", superblock error " << std::setprecision(3) << tt.grid_error() << '\n';
+            }
+        }
 
-        /* Then, the f(x_i,y)*f(x,y_j) parts */
-        for (size_t i = 0; i < m_pivots.size(); ++i)
-            for (size_t j = 0; j < m_pivots.size(); ++j)
-                if (m_ek[j][i])
-                    ret += m_ek[j][i] * eval_f(m_pivots[i].x, y) * eval_f(x, m_pivots[j].y);
+        // Approximate each entry of each G_k with a polynomial
+        int const check_samples = 1024;
+        real const tt_error = tt.check_error(check_samples);
 
-        return ret;
-    }
+        struct factor
+        {
+            int k, a, b;
+            lol::polynomial<real> p;
+            real error;
+        };
+
+        std::vector<factor> factors;
+        for (int k = 0; k < variables; ++k)
+            for (int a = 0; a < tt.rank(k - 1); ++a)
+                for (int b = 0; b < tt.rank(k); ++b)
+                    factors.push_back({ k, a, b, {}, real() });
+
+        fprintf(stderr, "Fitting %d factors…\r", (int)factors.size());
+        fflush(stderr);
+        int unconverged = 0;
+        for (auto &f : factors)
+            unconverged += !fit_factor([&](real const &x) { return tt.eval_factor(f.k, f.a, f.b, x); },
+                                       mins[f.k], maxs[f.k], degree, info.digits, f.p, f.error);
+
+        if (show_progress)
+            for (auto const &f : factors)
+                std::cout << "factor " << names[f.k] << " (" << f.a << "," << f.b
+                          << "): polynomial error " << std::setprecision(3) << f.error << '\n';
+
+        // Check the final approximation, as a product of polynomial matrices
+        real const total_error = tt.check_error(check_samples, [&](std::vector<real> const &xs)
+        {
+            std::vector<real> v(1, real::R_1());
+            for (int k = 0; k < variables; ++k)
+            {
+                std::vector<real> next(tt.rank(k), real::R_0());
+                for (auto const &f : factors)
+                    if (f.k == k)
+                        next[f.b] += v[f.a] * f.p.eval(xs[k]);
+                v = next;
+            }
+            return v[0];
+        });
 
-    void dump_gnuplot()
-    {
-        std::cout << "f(x,y)=sin((1-x)/2*acos((1+y)/2))/sqrt(1-((y+1)/2)**2)\n";
-        std::cout << "e0(x,y)=f(x,y)\n";
-        //printf("f0(x,y)=0\n");
+        // Factor names: f_x<b> for the first variable, f_z<a> for the last,
+        // and f_y<a>_<b> in between
+        auto const factor_name = [&](factor const &f)
+        {
+            std::string ret = std::string("f_") + names[f.k];
+            if (f.k > 0)
+                ret += std::to_string(f.a);
+            if (f.k > 0 && f.k < variables - 1)
+                ret += "_";
+            if (f.k < variables - 1)
+                ret += std::to_string(f.b);
+            return ret;
+        };
+
+        // Print final estimate
+        char const *type = info.name;
+        std::cout << "// Tensor-train approximation of f(" << names[0];
+        for (int k = 1; k < variables; ++k)
+            std::cout << "," << names[k];
+        std::cout << ") = " << expr << '\n';
+        std::cout << "// on [ " << str_ranges[0] << " ]";
+        for (int k = 1; k < variables; ++k)
+            std::cout << " × [ " << str_ranges[k] << " ]";
+        std::cout << " with ranks";
+        for (int k = 0; k < variables - 1; ++k)
+            std::cout << (k ? ", " : " ") << tt.rank(k);
+        std::cout << " and degree " << degree << " polynomials\n";
+        std::cout << std::setprecision(3);
+        std::cout << "// Max error on " << check_samples << " check points, before rounding: "
+                  << "tensor train " << tt_error << ", with polynomials " << total_error << '\n';
+        if (tt.grid_error() > target)
+            std::cout << "// Warning: tolerance " << target << " not met with rank " << max_rank << '\n';
+        if (unconverged)
+            std::cout << "// Warning: Remez iteration limit reached for " << unconverged
+                      << " of " << factors.size() << " factors\n";
+
+        for (auto const &f : factors)
+        {
+            std::cout << '\n';
+            code_generator gen(f.p, mode, eval_scheme::horner(f.p.degree()));
+            gen.set_name(factor_name(f));
+            gen.set_hex(display_hex);
+            gen.emit_scalar(std::cout);
+        }
 
-        std::cout << std::setprecision(20);
-        for (int n = 0; n < (int)m_pivots.size(); ++n)
+        // v_k = v_{k-1}·G_k(x_k), one row vector per variable
+        std::cout << '\n' << type << " f(";
+        for (int k = 0; k < variables; ++k)
+            std::cout << (k ? ", " : "") << type << ' ' << names[k];
+        std::cout << ")\n{\n";
+        for (int k = 0; k < variables; ++k)
         {
-            std::cout << 'x' << (n+1) << '=' << m_pivots[n].x << '\n';
-            std::cout << 'y' << (n+1) << '=' << m_pivots[n].y << '\n';
-            std::cout << 'd' << (n+1) << "=e" << n << "(x" << (n+1) << ",y" << (n+1) << ")\n";
-            std::cout << 'e' << (n+1) << "(x,y)=e" << n << "(x,y)-e" << n
-                      << "(x" << (n+1) << ",y)*e" << n << "(x,y" << (n+1)
-                      << ")/d" << (n+1) << '\n';
-            //printf("f%d(x,y)=f%d(x,y)+e%d(x%d,y)*e%d(x,y%d)/d%d\n", n+1, n, n, n+1, n, n+1, n+1);
+            if (k < variables - 1)
+                std::cout << "    " << type << " const v" << k << "[" << tt.rank(k) << "] =\n    {\n";
+            else
+                std::cout << "    return ";
+            for (int b = 0; b < tt.rank(k); ++b)
+            {
+                if (k < variables - 1)
+                    std::cout << "        ";
+                bool first = true;
+                for (auto const &f : factors)
+                    if (f.k == k && f.b == b)
+                    {
+                        std::cout << (first ? "" : k < variables - 1 ? "\n          + " : "\n         + ");
+                        if (k > 0)
+                            std::cout << "v" << (k - 1) << "[" << f.a << "] * ";
+                        std::cout << factor_name(f) << "(" << names[k] << ")";
+                        first = false;
+                    }
+                std::cout << (k < variables - 1 ? ",\n" : ";\n");
+            }
+            if (k < variables - 1)
+                std::cout << "    };\n";
         }
+        std::cout << "}\n";
 
-        std::cout << "splot [-1:1][-1:1] e" << m_pivots.size() << "(x,y)\n";
+        return EXIT_SUCCESS;
     }
 
-private:
-    real cheb(int i, int n)
+    // Add terms until the error on the grid, then between grid points,
+    // meets the tolerance
+    cross_solver cross(f, xmin, xmax, ymin, ymax, grid_size, max_rank);
+
+    real const target = tolerance ? real(*tolerance) : ulp(cross.grid_error(), mode);
+
+    real cross_error = cross.grid_error();
+    while (cross.rank() < max_rank && !cross.grid_error().is_zero())
+    {
+        cross.step();
+        if (show_progress)
+            std::cout << "rank " << cross.rank() << ": grid error "
+                      << std::setprecision(3) << cross.grid_error() << '\n';
+        if (cross.grid_error() > target)
+            continue;
+        cross_error = cross.check_error();
+        if (show_progress)
+            std::cout << "rank " << cross.rank() << ": error between grid points "
+                      << std::setprecision(3) << cross_error << '\n';
+        if (cross_error <= target)
+            break;
+    }
+    if (cross.rank() == max_rank && cross_error > target)
+        cross_error = cross.check_error();
+
+    // Approximate each univariate factor with a polynomial
+    int const rank = cross.rank();
+    std::vector<lol::polynomial<real>> g(rank), h(rank);
+    std::vector<real> g_error(rank), h_error(rank);
+
+    fprintf(stderr, "Fitting %d factors…\r", 2 * rank);
+    fflush(stderr);
+    int unconverged = 0;
+    for (int k = 0; k < rank; ++k)
     {
-        return -cos(real::R_PI() * i / n) * real("0.999999999999999");
+        unconverged += !fit_factor([&cross, k](real const &x) { return cross.eval_g(k, x); },
+                                   xmin, xmax, degree, info.digits, g[k], g_error[k]);
+        unconverged += !fit_factor([&cross, k](real const &y) { return cross.eval_h(k, y); },
+                                   ymin, ymax, degree, info.digits, h[k], h_error[k]);
     }
 
-    int m_grid_size;
-    int m_iters;
-
-    /*
-     * Our “meta-function” structure. It has a matrix of coefficients that
-     * contains the contribution of f(x_i,y)f(x,y_j) to this function. Since
-     * this function is the error function, it has an implicit f(x,y) added
-     * to it because of the algorithm’s setup.
-     *
-     * Using this kind of storage, we can add meta-functions together, and
-     * evaluate them at a given point or along a given x or y line.
-     */
-    array2d<real> m_ek;
-
-    std::vector<real> m_coeff;
-    std::vector<real2> m_pivots;
-};
-
-int main()
-{
-    int const grid_size = 33;
-    int const iters = 6;
+    if (show_progress)
+        for (int k = 0; k < rank; ++k)
+            std::cout << "term " << k << ": polynomial error " << std::setprecision(3)
+                      << g_error[k] << " in x, " << h_error[k] << " in y\n";
 
-    /* Create solver and iterate */
-    solver s(grid_size, iters);
-    for (int n = 0; n < iters; ++n)
-        s.step();
+    // Check the final approximation between grid points
+    real const total_error = cross.check_error([&](real const &x, real const &y)
+    {
+        real ret(0);
+        for (int k = 0; k < rank; ++k)
+            ret += g[k].eval(x) * h[k].eval(y);
+        return ret;
+    });
+
+    // Print final estimate
+    char const *type = info.name;
+    std::cout << "// Rank " << rank << " approximation of f(x,y) = " << expr << '\n';
+    std::cout << "// on [ " << str_xrange << " ] × [ " << str_yrange << " ]"
+              << " with degree " << degree << " polynomials\n";
+    std::cout << std::setprecision(3);
+    std::cout << "// Max error between grid points, before rounding: separable " << cross_error
+              << ", with polynomials " << total_error << '\n';
+    if (cross_error > target)
+        std::cout << "// Warning: tolerance " << target << " not met with " << max_rank << " terms\n";
+    if (unconverged)
+        std::cout << "// Warning: Remez iteration limit reached for " << unconverged
+                  << " of " << 2 * rank << " factors\n";
+
+    for (int k = 0; k < rank; ++k)
+    {
+        std::cout << '\n';
+        code_generator gen(g[k], mode, eval_scheme::horner(g[k].degree()));
+        gen.set_name("f_g" + std::to_string(k));
+        gen.set_hex(display_hex);
+        gen.emit_scalar(std::cout);
+
+        std::cout << '\n';
+        code_generator gen2(h[k], mode, eval_scheme::horner(h[k].degree()));
+        gen2.set_name("f_h" + std::to_string(k));
+        gen2.set_hex(display_hex);
+        gen2.emit_scalar(std::cout);
+    }
 
-    /* Dump gnuplot data about the solver */
-    s.dump_gnuplot();
+    std::cout << '\n' << type << " f(" << type << " x, " << type << " y)\n{\n";
+    std::cout << "    return ";
+    for (int k = 0; k < rank; ++k)
+        std::cout << (k ? "\n         + " : "") << "f_g" << k << "(x) * f_h" << k << "(y)";
+    std::cout << ";\n}\n";
 
     return EXIT_SUCCESS;
 }
-
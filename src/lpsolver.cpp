@@ -0,0 +1,312 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::min, std::sort, std::unique
+#include <functional>
+#include <iostream>
+#include <iomanip>
+
+#include <lol/math>
+#include <lol/real>
+
+#include "lpsolver.h"
+
+using lol::real;
+
+/* Grid points are processed by chunks. Kinds of worker jobs: sampling
+ * chunk c of the new points is job c of sample_job, and computing the
+ * errors of chunk c of the grid is job c of error_job. */
+static int const chunk = 64;
+static int const sample_job = 1;
+static int const error_job = 2;
+
+// Maximum number of times the grid is refined around the largest errors
+static int const refine_levels = 8;
+
+static int chunks(size_t n)
+{
+    return int((n + chunk - 1) / chunk);
+}
+
+lp_solver::lp_solver(function const &f, function const &g, real const &xmin,
+                     real const &xmax, int order)
+  : m_func(f),
+    m_weight(g),
+    m_order(order),
+    m_k1((xmax + xmin) / 2),
+    m_k2((xmax - xmin) / 2),
+    m_lp(order + 2),
+    m_pool([this](int i) { return do_job(i); })
+{
+    std::vector<real> objective(order + 2, real::R_0());
+    objective[order + 1] = real::R_1();
+    m_lp.set_objective(objective);
+
+    // E ≥ 0, which the other constraints only imply for two-sided errors
+    std::vector<real> row(order + 2, real::R_0());
+    row[order + 1] = -real::R_1();
+    m_lp.add_constraint(row, real::R_0());
+
+    // Dense grid of Chebyshev extrema
+    int const n = 64 * (order + 2);
+    m_samples.resize(n + 1);
+    for (int i = 0; i <= n; ++i)
+    {
+        m_samples[i].t = -cos(real::R_PI() * i / n);
+        m_pending.push_back(i);
+    }
+
+    m_pool.run(sample_job, chunks(m_pending.size()));
+    m_pending.clear();
+}
+
+void lp_solver::add_constraint(int power, relation rel, real const &value)
+{
+    // Coefficient of x^power in each T_n((x - k1) / k2)
+    std::vector<real> row(m_order + 2, real::R_0());
+    if (power <= m_order)
+    {
+        lol::polynomial<real> const q({ -m_k1 / m_k2, real::R_1() / m_k2 });
+        for (int n = 0; n <= m_order; ++n)
+        {
+            auto const p = lol::polynomial<real>::chebyshev(n).eval(q);
+            row[n] = power <= p.degree() ? p[power] : real::R_0();
+        }
+    }
+    else
+    {
+        // The coefficient is zero; only check that this is allowed
+        if ((rel == relation::equal && !value.is_zero())
+             || (rel == relation::less_equal && value < real::R_0())
+             || (rel == relation::greater_equal && value > real::R_0()))
+            m_feasible = false;
+        return;
+    }
+
+    if (rel == relation::equal)
+        m_lp.add_equality(row, value);
+    else if (rel == relation::less_equal)
+        m_lp.add_constraint(row, value);
+    else
+    {
+        for (auto &x : row)
+            x = -x;
+        m_lp.add_constraint(row, -value);
+    }
+
+    if (power == 0)
+        m_constant_fixed = true;
+}
+
+bool lp_solver::solve(double gap, int max_iterations, bool show_progress)
+{
+    if (!m_feasible)
+        return false;
+
+    // Machine epsilon of the current precision; the simplex treats values
+    // below its square root as zero.
+    real eps = real::R_1();
+    while (real::R_1() + eps / 2 != real::R_1())
+        eps /= 2;
+    real const tolerance = sqrt(eps);
+
+    // Start with one grid point in 16, about four per coefficient
+    for (size_t i = 0; i < m_samples.size(); i += 16)
+        add_point(i);
+
+    real bound(0);
+    bool refined = false;
+    for (int iteration = 0, level = 0; iteration < max_iterations; ++iteration)
+    {
+        fprintf(stderr, "LP iteration: %d\r", iteration);
+        fflush(stderr);
+
+        auto const status = m_lp.solve(tolerance, 100000);
+        if (status == linear_program<real>::status::infeasible
+             || status == linear_program<real>::status::unbounded)
+            return false;
+
+        // Without an anti-cycling rule, the simplex may stall on degenerate
+        // grids: keep the solution of the previous iteration, if there is one
+        if (status == linear_program<real>::status::iteration_limit)
+        {
+            m_limit_reached = true;
+            if (iteration == 0)
+                return false;
+            break;
+        }
+
+        m_solution.assign(m_lp.solution().begin(), m_lp.solution().end() - 1);
+        bound = m_lp.solution().back();
+
+        m_bound = bound;
+        m_pool.run(error_job, chunks(m_samples.size()));
+        m_error = real::R_0();
+        for (auto const &s : m_samples)
+            m_error = max(m_error, fabs(s.err));
+
+        if (show_progress)
+            std::cout << "lp iteration " << iteration << ": " << m_lp.constraints()
+                      << " constraints, " << m_samples.size() << " grid points, error "
+                      << std::setprecision(3) << bound << " to " << m_error << '\n';
+
+        // Add the grid points where the excess has a local maximum above
+        // the threshold; one-sided constraints allow no slack at all
+        real const threshold = max(bound * real(gap), tolerance);
+        int added = 0;
+        for (size_t i = 0; i < m_samples.size(); ++i)
+        {
+            auto const &s = m_samples[i];
+            real const wrong_side = m_side == side::upper ? -s.err
+                                  : m_side == side::lower ? s.err : -tolerance;
+            if (s.active || (s.excess <= threshold && wrong_side <= tolerance))
+                continue;
+            if ((i > 0 && m_samples[i - 1].excess > s.excess)
+                 || (i + 1 < m_samples.size() && m_samples[i + 1].excess > s.excess))
+                continue;
+            add_point(i);
+            ++added;
+        }
+
+        // Stop when the last refinement found nothing new, except for
+        // one-sided errors where p may touch f between grid points
+        if (added)
+        {
+            refined = false;
+            continue;
+        }
+        if ((refined && m_side == side::both) || level++ >= refine_levels)
+            break;
+        refined = true;
+
+        // No violation on this grid: refine it halfway to the neighbours
+        // of the points where a constraint is nearly binding.
+        std::vector<real> ts;
+        for (size_t i = 0; i < m_samples.size(); ++i)
+        {
+            if (m_samples[i].excess < -threshold)
+                continue;
+            if (i > 0)
+                ts.push_back((m_samples[i - 1].t + m_samples[i].t) / 2);
+            if (i + 1 < m_samples.size())
+                ts.push_back((m_samples[i].t + m_samples[i + 1].t) / 2);
+        }
+        std::sort(ts.begin(), ts.end());
+        ts.erase(std::unique(ts.begin(), ts.end()), ts.end());
+
+        // Sample the new points, then merge them into the grid
+        for (auto const &t : ts)
+        {
+            m_pending.push_back(m_samples.size());
+            m_samples.emplace_back();
+            m_samples.back().t = t;
+        }
+        m_pool.run(sample_job, chunks(m_pending.size()));
+        m_pending.clear();
+        std::sort(m_samples.begin(), m_samples.end(),
+                  [](sample const &a, sample const &b) { return a.t < b.t; });
+    }
+
+    // For one-sided errors, the grid does not see everything in between
+    // its points: move p by the largest violation, so that the constraint
+    // at least holds on the whole grid.
+    if (m_side != side::both && !m_constant_fixed)
+    {
+        real shift(0);
+        for (auto const &s : m_samples)
+        {
+            real const e = m_side == side::upper ? -s.err : s.err;
+            shift = max(shift, e / s.inv_g);
+        }
+        m_solution[0] += m_side == side::upper ? shift : -shift;
+
+        m_pool.run(error_job, chunks(m_samples.size()));
+        m_error = real::R_0();
+        for (auto const &s : m_samples)
+            m_error = max(m_error, fabs(s.err));
+    }
+
+    return true;
+}
+
+void lp_solver::add_point(size_t i)
+{
+    auto &s = m_samples[i];
+    s.active = true;
+
+    // φ_n = T_n(t) / g, and the rows for p - f ≤ E, f - p ≤ E, p ≥ f
+    // and p ≤ f as needed
+    std::vector<real> phi(m_order + 2, real::R_0());
+    for (int n = 0; n <= m_order; ++n)
+        phi[n] = n == 0 ? s.inv_g : n == 1 ? s.t * s.inv_g : 2 * s.t * phi[n - 1] - phi[n - 2];
+
+    std::vector<real> neg(phi);
+    for (auto &x : neg)
+        x = -x;
+
+    phi[m_order + 1] = m_side == side::lower ? real::R_0() : -real::R_1();
+    neg[m_order + 1] = m_side == side::upper ? real::R_0() : -real::R_1();
+
+    m_lp.add_constraint(phi, s.fx);
+    m_lp.add_constraint(neg, -s.fx);
+}
+
+// Clenshaw’s recurrence for Σ a_n·T_n(t)
+real lp_solver::eval(real const &t) const
+{
+    real b1(0), b2(0);
+    for (int n = m_order; n >= 1; --n)
+    {
+        real const b0 = m_solution[n] + 2 * t * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return m_solution[0] + t * b1 - b2;
+}
+
+// Worker threads handle jobs from the main thread, each on a chunk of
+// grid points.
+int lp_solver::do_job(int i)
+{
+    int const kind = worker_pool::job_kind(i), c = worker_pool::job_index(i);
+
+    if (kind == error_job)
+    {
+        size_t const end = std::min(m_samples.size(), size_t(c + 1) * chunk);
+        for (size_t k = size_t(c) * chunk; k < end; ++k)
+        {
+            auto &s = m_samples[k];
+            s.err = eval(s.t) * s.inv_g - s.fx;
+            s.excess = m_side == side::both ? fabs(s.err) - m_bound
+                     : m_side == side::upper ? max(-s.err, s.err - m_bound)
+                     : max(s.err, -s.err - m_bound);
+        }
+    }
+    else if (kind == sample_job)
+    {
+        size_t const end = std::min(m_pending.size(), size_t(c + 1) * chunk);
+        for (size_t k = size_t(c) * chunk; k < end; ++k)
+        {
+            auto &s = m_samples[m_pending[k]];
+            real const x = s.t * m_k2 + m_k1;
+            s.inv_g = m_weight ? real::R_1() / fabs(m_weight(x)) : real::R_1();
+            s.fx = m_func(x) * s.inv_g;
+            s.err = s.excess = real::R_0();
+        }
+    }
+
+    return i;
+}
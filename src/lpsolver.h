@@ -0,0 +1,114 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The lp_solver class
+// -------------------
+//
+// Minimax polynomial as a linear program: minimise E subject to
+//   -E ≤ (p(x_i) - f(x_i)) / g(x_i) ≤ E
+// at a set of points x_i. Unlike the Remez exchange, this allows extra
+// linear constraints: one-sided errors, where p ≥ f or p ≤ f everywhere,
+// and equalities or inequalities on the coefficients of p. The points
+// are taken from a dense grid where the constraints are violated, and the
+// grid itself is refined around the largest errors.
+//
+
+#include <lol/real>
+
+#include <functional>
+#include <vector>
+
+#include "pool.h"
+#include "simplex.h"
+
+class lp_solver
+{
+public:
+    typedef std::function<lol::real(lol::real const &)> function;
+
+    enum class side
+    {
+        both,
+        upper, // p ≥ f
+        lower, // p ≤ f
+    };
+
+    enum class relation
+    {
+        equal,
+        less_equal,
+        greater_equal,
+    };
+
+    // Approximate f/g, or f if g is empty; f and g must be safe to call
+    // from several threads
+    lp_solver(function const &f, function const &g, lol::real const &xmin,
+              lol::real const &xmax, int order);
+
+    // One-sided errors hold between the grid points only if the constant
+    // coefficient is free, since p is moved by it after solving
+    void set_side(side s) { m_side = s; }
+
+    // Constrain the coefficient of x^power in p; coefficients above the
+    // degree of p are zero
+    void add_constraint(int power, relation rel, lol::real const &value);
+
+    // Solve, adding violated points and refining the grid until no
+    // constraint is violated by more than “gap” times the error. Returns
+    // false if the constraints cannot all be met, or if the simplex
+    // reached its iteration limit before finding any solution.
+    bool solve(double gap, int max_iterations, bool show_progress);
+
+    // Whether the simplex reached its iteration limit; the solution is
+    // then the last one it found
+    bool limit_reached() const { return m_limit_reached; }
+
+    // Largest weighted error on the grid
+    lol::real get_error() const { return m_error; }
+    int get_grid_size() const { return (int)m_samples.size(); }
+
+    // The estimate as Σ a_n·T_n(t) with t = (x - k1) / k2, as in remez_solver
+    std::vector<lol::real> const &get_chebyshev() const { return m_solution; }
+
+private:
+    void add_point(size_t i);
+    lol::real eval(lol::real const &t) const;
+    int do_job(int i);
+
+    function m_func, m_weight;
+    int m_order;
+    lol::real m_k1, m_k2;
+    side m_side = side::both;
+    bool m_feasible = true, m_constant_fixed = false, m_limit_reached = false;
+
+    // Grid points, sorted by t, with f/g and 1/g; “err” is the signed
+    // weighted error and “excess” how much it violates the constraints
+    struct sample
+    {
+        lol::real t, fx, inv_g, err, excess;
+        bool active = false;
+    };
+
+    std::vector<sample> m_samples;
+    std::vector<size_t> m_pending;
+
+    // Variables are the Chebyshev coefficients, then E
+    linear_program<lol::real> m_lp;
+    std::vector<lol::real> m_solution;
+    lol::real m_bound, m_error;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
@@ -0,0 +1,250 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::min
+#include <functional>
+#include <iostream>
+#include <iomanip>
+
+#include <lol/math>
+#include <lol/real>
+
+#include "minimax2d.h"
+
+using lol::real;
+
+/* New points are sampled by chunks. Kinds of worker jobs: sampling chunk
+ * c of the new points is job c of sample_job, and checking midpoint row j
+ * is job j of check_job; the Lawson steps themselves run in the core. */
+static int const chunk = 64;
+static int const sample_job = 1;
+static int const check_job = 2;
+
+static int chunks(size_t n)
+{
+    return int((n + chunk - 1) / chunk);
+}
+
+minimax2d_solver::minimax2d_solver(function const &f, real const &xmin, real const &xmax,
+                                   real const &ymin, real const &ymax,
+                                   int degree, int grid_size)
+  : m_func(f),
+    m_degree(degree),
+    m_grid_size(grid_size),
+    m_xmin(xmin),
+    m_xmax(xmax),
+    m_ymin(ymin),
+    m_ymax(ymax),
+    m_pool([this](int i) { return do_job(i); })
+{
+    for (int j = 0; j <= degree; ++j)
+        for (int i = 0; i + j <= degree; ++i)
+            m_basis.push_back({ i, j });
+
+    // Chebyshev extrema, and the midpoints between them for checking
+    auto cheb = [](real const &a, real const &b, int i, int n)
+    {
+        return a + (b - a) * (real::R_1() - cos(real::R_PI() * i / n)) / 2;
+    };
+
+    for (int j = 0; j <= grid_size; ++j)
+        for (int i = 0; i <= grid_size; ++i)
+            add_point(cheb(xmin, xmax, i, grid_size), cheb(ymin, ymax, j, grid_size));
+
+    for (int i = 0; i < grid_size; ++i)
+    {
+        m_check_xs.push_back(cheb(xmin, xmax, 2 * i + 1, 2 * grid_size));
+        m_check_ys.push_back(cheb(ymin, ymax, 2 * i + 1, 2 * grid_size));
+    }
+}
+
+bool minimax2d_solver::solve(double gap, int max_iterations, int refinements, bool show_progress)
+{
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        fprintf(stderr, "Iteration: %d\r", iteration);
+        fflush(stderr);
+
+        lawson_step();
+        auto &points = m_core.points();
+        real const error = m_core.get_error(), lower = m_core.get_lower_bound();
+        if (show_progress)
+            std::cout << "iteration " << iteration << ": " << points.size() << " points, error "
+                      << std::setprecision(3) << lower << " to " << error << '\n';
+
+        if (error - lower > error * real(gap))
+            continue;
+
+        // Converged on this point set; look between the grid points for
+        // larger errors, which become new points.
+        size_t const count = points.size();
+        if (refinements-- <= 0 || check_error() <= error * real(1 + gap) || points.size() == count)
+        {
+            update_coeffs();
+            return true;
+        }
+
+        // New points start with the largest weight of the current set
+        real w(0);
+        for (size_t n = 0; n < count; ++n)
+            w = max(w, points[n].weight);
+        for (size_t n = count; n < points.size(); ++n)
+            points[n].weight = w;
+    }
+
+    update_coeffs();
+    return false;
+}
+
+real minimax2d_solver::check_error()
+{
+    size_t const count = m_coords.size();
+
+    m_row_error.resize(m_grid_size);
+    m_row_extra.resize(m_grid_size);
+    m_pool.run(check_job, m_grid_size);
+
+    // Add the points where the error exceeds the current error, in row
+    // order so that the result does not depend on thread timings
+    real ret(0);
+    for (int j = 0; j < m_grid_size; ++j)
+    {
+        ret = max(ret, m_row_error[j]);
+        for (auto const &x : m_row_extra[j])
+            add_point(x, m_check_ys[j]);
+    }
+
+    if (m_coords.size() > count)
+    {
+        m_sampled = count;
+        m_pool.run(sample_job, chunks(m_coords.size() - count));
+        m_sampled = m_coords.size();
+    }
+    return ret;
+}
+
+real minimax2d_solver::eval(real const &x, real const &y) const
+{
+    real const s = (x + x - m_xmin - m_xmax) / (m_xmax - m_xmin);
+    real const t = (y + y - m_ymin - m_ymax) / (m_ymax - m_ymin);
+
+    real ret(0);
+    for (size_t b = 0; b < m_basis.size(); ++b)
+    {
+        real m = m_core.get_solution()[b];
+        for (int i = 0; i < m_basis[b][0]; ++i)
+            m *= s;
+        for (int j = 0; j < m_basis[b][1]; ++j)
+            m *= t;
+        ret += m;
+    }
+    return ret;
+}
+
+void minimax2d_solver::add_point(real const &x, real const &y)
+{
+    m_coords.push_back({ x, y });
+    m_core.points().emplace_back();
+}
+
+void minimax2d_solver::lawson_step()
+{
+    // Sample new points
+    if (m_sampled < m_coords.size())
+    {
+        m_pool.run(sample_job, chunks(m_coords.size() - m_sampled));
+        m_sampled = m_coords.size();
+    }
+
+    m_core.step();
+}
+
+// Rewrite Σ c_ij·s^i·t^j as Σ_j P_j(x)·y^j
+void minimax2d_solver::update_coeffs()
+{
+    real const kx = real(2) / (m_xmax - m_xmin), ky = real(2) / (m_ymax - m_ymin);
+    lol::polynomial<real> const sx({ -(m_xmin + m_xmax) / (m_xmax - m_xmin), kx });
+    lol::polynomial<real> const ty({ -(m_ymin + m_ymax) / (m_ymax - m_ymin), ky });
+
+    m_estimate.assign(m_degree + 1, lol::polynomial<real>());
+
+    lol::polynomial<real> tj({ real::R_1() });
+    for (int j = 0; j <= m_degree; ++j)
+    {
+        // P_j(x) = Σ_i c_ij·s(x)^i
+        lol::polynomial<real> c;
+        for (size_t b = 0; b < m_basis.size(); ++b)
+            if (m_basis[b][1] == j)
+                c.set(m_basis[b][0], m_core.get_solution()[b]);
+        auto const pj = c.eval(sx);
+
+        for (int l = 0; l <= tj.degree(); ++l)
+            m_estimate[l] += pj * tj[l];
+
+        tj = tj * ty;
+    }
+}
+
+// Worker threads handle jobs from the main thread, each on a chunk of
+// new points or a row of midpoints.
+int minimax2d_solver::do_job(int i)
+{
+    int const kind = worker_pool::job_kind(i), c = worker_pool::job_index(i);
+
+    if (kind == check_job)
+    {
+        // Midpoint row c: largest error, and points to add
+        real const &y = m_check_ys[c];
+        real const limit = m_core.get_error();
+        real err(0);
+        m_row_extra[c].clear();
+        for (auto const &x : m_check_xs)
+        {
+            real const e = fabs(m_func(x, y) - eval(x, y));
+            err = max(err, e);
+            if (e > limit)
+                m_row_extra[c].push_back(x);
+        }
+        m_row_error[c] = err;
+    }
+    else if (kind == sample_job)
+    {
+        size_t const size = m_basis.size();
+        size_t const end = std::min(m_coords.size(), m_sampled + size_t(c + 1) * chunk);
+        for (size_t k = m_sampled + size_t(c) * chunk; k < end; ++k)
+        {
+            auto &p = m_core.points()[k];
+            real const &x = m_coords[k][0], &y = m_coords[k][1];
+            real const s = (x + x - m_xmin - m_xmax) / (m_xmax - m_xmin);
+            real const t = (y + y - m_ymin - m_ymax) / (m_ymax - m_ymin);
+
+            p.fx = m_func(x, y);
+            p.weight = m_seed ? fabs(p.fx - m_seed(x, y)) : real::R_1();
+            p.basis.resize(size);
+            for (size_t b = 0; b < size; ++b)
+            {
+                real m = real::R_1();
+                for (int n = 0; n < m_basis[b][0]; ++n)
+                    m *= s;
+                for (int n = 0; n < m_basis[b][1]; ++n)
+                    m *= t;
+                p.basis[b] = m;
+            }
+        }
+    }
+
+    return i;
+}
@@ -0,0 +1,102 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The minimax2d_solver class
+// --------------------------
+//
+// Minimax polynomial p(x,y) of bounded total degree. The alternation
+// theorem does not hold in two dimensions, so there is no exchange
+// algorithm; instead, Lawson’s algorithm solves a sequence of weighted
+// least squares problems on a set of points, multiplying each weight by
+// the error at that point:
+//   w_i ← w_i·|f(x_i,y_i) - p(x_i,y_i)| / Σ w_j·|f(x_j,y_j) - p(x_j,y_j)|
+// which converges to the minimax polynomial on that point set. Then the
+// points between grid points where the error is larger are added to the
+// set, and the iteration resumes.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "lawson.h"
+#include "pool.h"
+
+class minimax2d_solver
+{
+public:
+    typedef std::function<lol::real(lol::real const &, lol::real const &)> function;
+
+    // f must be safe to call from several threads
+    minimax2d_solver(function const &f, lol::real const &xmin, lol::real const &xmax,
+                     lol::real const &ymin, lol::real const &ymax,
+                     int degree, int grid_size);
+
+    // Start with weights proportional to the error of an approximation,
+    // such as a truncated Chebyshev interpolant, instead of equal weights
+    void set_seed(function const &approx) { m_seed = approx; }
+
+    // Run Lawson iterations until the lower and upper bounds on the error
+    // are within “gap” of each other, then refine the point set, up to
+    // “refinements” times. Returns false if the iteration limit is hit.
+    bool solve(double gap, int max_iterations, int refinements, bool show_progress);
+
+    // Largest error on the point set, and a lower bound on the minimax
+    // error on that set
+    lol::real get_error() const { return m_core.get_error(); }
+    lol::real get_lower_bound() const { return m_core.get_lower_bound(); }
+
+    // Largest error halfway between the grid points
+    lol::real check_error();
+
+    lol::real eval(lol::real const &x, lol::real const &y) const;
+
+    // The polynomial as Σ_j p[j](x)·y^j
+    std::vector<lol::polynomial<lol::real>> const &get_estimate() const { return m_estimate; }
+
+private:
+    void add_point(lol::real const &x, lol::real const &y);
+    void lawson_step();
+    void update_coeffs();
+    int do_job(int i);
+
+    function m_func, m_seed;
+    int m_degree, m_grid_size;
+    lol::real m_xmin, m_xmax, m_ymin, m_ymax;
+
+    // Basis monomials s^i·t^j on the scaled variables s and t in [-1,1]
+    std::vector<std::array<int, 2>> m_basis;
+
+    // Coordinates of the points of the core, of which the first
+    // “m_sampled” have their basis and f(x,y) filled in
+    std::vector<std::array<lol::real, 2>> m_coords;
+    size_t m_sampled = 0;
+    std::vector<lol::real> m_check_xs, m_check_ys;
+
+    // Lawson’s iteration, whose solution is in the scaled basis, and that
+    // solution as polynomials in x for each y^j
+    lawson_core m_core;
+    std::vector<lol::polynomial<lol::real>> m_estimate;
+
+    // Largest error, and points to add, on each row of midpoints
+    std::vector<lol::real> m_row_error;
+    std::vector<std::vector<lol::real>> m_row_extra;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};
@@ -0,0 +1,322 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring> // std::memset, std::strerror
+#include <iomanip>
+#include <mutex>
+
+#if __linux__
+#   include <linux/perf_event.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+#include "perf.h"
+
+// Counted events, in the order they are printed
+static int const event_count = 4;
+static int const phase_count = 3;
+
+static char const *event_names[event_count] =
+{
+    "cycles", "instructions", "cache misses", "branch misses",
+};
+
+static char const *phase_names[phase_count] =
+{
+    "find_extrema", "remez_step", "find_zeros",
+};
+
+#if __linux__
+static uint64_t const event_configs[event_count] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+#endif
+
+namespace
+{
+
+struct thread_info
+{
+    long tid = 0;
+    int fd[event_count] = { -1, -1, -1, -1 };
+    uint64_t total[phase_count][event_count] = {};
+};
+
+struct phase_info
+{
+    int calls = 0;
+    double seconds = 0.0;
+};
+
+struct state
+{
+    std::mutex mutex;
+    std::atomic<bool> started { false };
+
+    // Events that could be opened on the main thread; the workers do not
+    // try the others
+    bool available[event_count] = {};
+
+    // The main thread is always first
+    std::vector<thread_info> threads;
+    phase_info phases[phase_count];
+
+    static state &get()
+    {
+        static state s;
+        return s;
+    }
+
+    ~state()
+    {
+#if __linux__
+        for (auto const &t : threads)
+            for (int fd : t.fd)
+                if (fd >= 0)
+                    close(fd);
+#endif
+    }
+};
+
+}
+
+#if __linux__
+static long current_tid()
+{
+    return syscall(SYS_gettid);
+}
+
+// User space events of one thread, whatever CPU it runs on
+static int open_event(long tid, int event)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event_configs[event];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, (pid_t)tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// When there are more events than hardware counters, the kernel takes
+// turns between them: scale the count to the whole time it was enabled.
+static uint64_t read_event(int fd)
+{
+    uint64_t data[3];
+    if (fd < 0 || read(fd, data, sizeof(data)) != (ssize_t)sizeof(data) || !data[2])
+        return 0;
+    return data[1] == data[2] ? data[0]
+         : uint64_t((double)data[0] * (double)data[1] / (double)data[2]);
+}
+#else
+static long current_tid()
+{
+    return 0;
+}
+
+static uint64_t read_event(int)
+{
+    return 0;
+}
+#endif
+
+static void open_events(state &s, thread_info &t)
+{
+#if __linux__
+    for (int e = 0; e < event_count; ++e)
+        if (s.available[e])
+            t.fd[e] = open_event(t.tid, e);
+#else
+    (void)s;
+    (void)t;
+#endif
+}
+
+void perf_counters::add_thread()
+{
+    auto &s = state::get();
+    std::unique_lock<std::mutex> lock(s.mutex);
+
+    // Make room for the main thread, which registers in start()
+    if (s.threads.empty())
+        s.threads.emplace_back();
+
+    s.threads.emplace_back();
+    s.threads.back().tid = current_tid();
+    if (s.started)
+        open_events(s, s.threads.back());
+}
+
+bool perf_counters::start(std::string &error)
+{
+    auto &s = state::get();
+    std::unique_lock<std::mutex> lock(s.mutex);
+
+    if (s.threads.empty())
+        s.threads.emplace_back();
+    s.threads[0].tid = current_tid();
+    s.started = true;
+
+#if __linux__
+    // Try each event on the main thread first; some CPUs or hypervisors
+    // only provide part of them
+    int first_errno = 0;
+    bool any = false;
+    for (int e = 0; e < event_count; ++e)
+    {
+        s.threads[0].fd[e] = open_event(s.threads[0].tid, e);
+        s.available[e] = s.threads[0].fd[e] >= 0;
+        if (!s.available[e] && !first_errno)
+            first_errno = errno;
+        any |= s.available[e];
+    }
+
+    if (!any)
+    {
+        error = first_errno == EACCES || first_errno == EPERM
+              ? "not permitted, see /proc/sys/kernel/perf_event_paranoid"
+              : first_errno == ENOENT || first_errno == EOPNOTSUPP || first_errno == ENOSYS
+              ? "not supported by this CPU or kernel"
+              : std::strerror(first_errno);
+        return false;
+    }
+
+    for (size_t i = 1; i < s.threads.size(); ++i)
+        open_events(s, s.threads[i]);
+    return true;
+#else
+    error = "only supported on Linux";
+    return false;
+#endif
+}
+
+perf_counters::scope::scope(phase p)
+  : m_phase(p),
+    m_active(state::get().started)
+{
+    if (!m_active)
+        return;
+
+    auto &s = state::get();
+    {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        for (auto const &t : s.threads)
+            for (int e = 0; e < event_count; ++e)
+                m_start.push_back(read_event(t.fd[e]));
+    }
+    m_time = std::chrono::steady_clock::now();
+}
+
+perf_counters::scope::~scope()
+{
+    if (!m_active)
+        return;
+
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_time);
+
+    auto &s = state::get();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    int const p = (int)m_phase;
+    s.phases[p].calls += 1;
+    s.phases[p].seconds += seconds.count();
+
+    // Threads that registered during the phase started from zero
+    for (size_t i = 0; i < s.threads.size(); ++i)
+    {
+        auto &t = s.threads[i];
+        for (int e = 0; e < event_count; ++e)
+        {
+            size_t const n = i * event_count + e;
+            uint64_t const start = n < m_start.size() ? m_start[n] : 0;
+            uint64_t const end = read_event(t.fd[e]);
+            t.total[p][e] += end > start ? end - start : 0;
+        }
+    }
+}
+
+// Counts as “1.23e+09 cycles, 2.46e+09 instructions (IPC 2.00), …”, with
+// cache misses per thousand instructions, which tells memory-bound code
+// from compute-bound code better than the raw count.
+static void print_events(std::ostream &os, state const &s, uint64_t const *count,
+                         char const *separator)
+{
+    for (int e = 0; e < event_count; ++e)
+    {
+        if (!s.available[e])
+            continue;
+        os << separator << (double)count[e] << ' ' << event_names[e];
+        separator = ", ";
+        if (e == 1 && s.available[0] && count[0])
+            os << " (IPC " << (double)count[1] / (double)count[0] << ')';
+        if (e == 2 && s.available[1] && count[1])
+            os << " (" << 1000.0 * (double)count[2] / (double)count[1] << " per 1k instructions)";
+    }
+}
+
+void perf_counters::report(std::ostream &os)
+{
+    auto &s = state::get();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    bool const counted = s.available[0] || s.available[1] || s.available[2] || s.available[3];
+
+    auto const flags = os.flags();
+    auto const precision = os.precision();
+    os << std::setprecision(3);
+
+    for (int p = 0; p < phase_count; ++p)
+    {
+        auto const &ph = s.phases[p];
+        if (!ph.calls)
+            continue;
+
+        uint64_t sum[event_count] = {};
+        for (auto const &t : s.threads)
+            for (int e = 0; e < event_count; ++e)
+                sum[e] += t.total[p][e];
+
+        os << " -:- " << phase_names[p] << ": " << ph.calls << " calls, "
+           << (ph.seconds * 1000.0) << " ms";
+        print_events(os, s, sum, ", ");
+        os << '\n';
+
+        // Threads that did not run during this phase are left out
+        for (size_t i = 0; counted && i < s.threads.size(); ++i)
+        {
+            auto const &t = s.threads[i];
+            if (!t.total[p][0] && !t.total[p][1])
+                continue;
+            os << " -:-   ";
+            if (i == 0)
+                os << "main";
+            else
+                os << "worker " << i;
+            print_events(os, s, t.total[p], ": ");
+            os << '\n';
+        }
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
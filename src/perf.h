@@ -0,0 +1,76 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The perf_counters class
+// -----------------------
+//
+// Hardware performance counters for the solver phases: CPU cycles,
+// instructions, cache misses and branch misses, counted in user space on
+// the main thread and on every worker of the pool, and summed over each
+// phase. This uses perf_event_open() on Linux; on other systems, or when
+// the kernel does not allow it (see /proc/sys/kernel/perf_event_paranoid),
+// the phases are only timed.
+//
+// Events of all threads are read at the start and at the end of a phase,
+// so whatever the workers run in between is charged to that phase. This
+// is accurate as long as only one solver uses the pool at a time.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class perf_counters
+{
+public:
+    enum class phase
+    {
+        extrema,
+        step,
+        zeros,
+    };
+
+    // Register the calling thread; worker threads do it before their
+    // first job
+    static void add_thread();
+
+    // Start timing the phases, and counting events on all threads, present
+    // and future. Returns false, with the reason in “error”, if no counter
+    // could be opened.
+    static bool start(std::string &error);
+
+    // Print the totals of each phase, then of each thread in that phase
+    static void report(std::ostream &os);
+
+    // Charge the events of all threads to a phase for the lifetime of
+    // this object; does nothing unless start() was called
+    class scope
+    {
+    public:
+        scope(phase p);
+        ~scope();
+
+        scope(scope const &) = delete;
+        scope &operator =(scope const &) = delete;
+
+    private:
+        phase m_phase;
+        bool m_active;
+        std::chrono::steady_clock::time_point m_time;
+        std::vector<uint64_t> m_start;
+    };
+};
@@ -0,0 +1,172 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max, std::find
+#include <thread>
+
+#include <lol/thread>
+
+#include "perf.h"
+#include "pool.h"
+
+worker_pool::client::client(std::function<int(int)> const &handler, priority p)
+  : m_handler(handler),
+    m_priority(p)
+{
+    get().attach(this);
+}
+
+worker_pool::client::~client()
+{
+    get().detach(this);
+}
+
+void worker_pool::client::set_priority(priority p)
+{
+    std::unique_lock<std::mutex> lock(get().m_mutex);
+    m_priority = p;
+}
+
+void worker_pool::client::push(int job)
+{
+    auto &pool = get();
+    std::unique_lock<std::mutex> lock(pool.m_mutex);
+    m_jobs.push_back(job);
+    pool.m_cv.notify_one();
+}
+
+int worker_pool::client::pop()
+{
+    std::unique_lock<std::mutex> lock(get().m_mutex);
+    m_cv.wait(lock, [this]() { return !m_answers.empty(); });
+    int const ret = m_answers.front();
+    m_answers.pop_front();
+    return ret;
+}
+
+void worker_pool::client::run(int kind, int count)
+{
+    {
+        auto &pool = get();
+        std::unique_lock<std::mutex> lock(pool.m_mutex);
+        for (int i = 0; i < count; ++i)
+            m_jobs.push_back(kind << 24 | i);
+        pool.m_cv.notify_all();
+    }
+
+    for (int i = 0; i < count; ++i)
+        pop();
+}
+
+int worker_pool::size()
+{
+    return (int)get().m_workers.size();
+}
+
+worker_pool &worker_pool::get()
+{
+    static worker_pool pool;
+    return pool;
+}
+
+worker_pool::worker_pool()
+{
+    /* Spawn worker threads */
+    for (unsigned int i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+    {
+        auto th = new lol::thread(std::bind(&worker_pool::worker_thread, this));
+        m_workers.push_back(th);
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    /* Signal worker threads to quit once there are no jobs left, and
+     * wait for them. */
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_cv.notify_all();
+    }
+
+    for (auto worker : m_workers)
+        delete worker;
+}
+
+void worker_pool::attach(client *c)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_clients.push_back(c);
+}
+
+void worker_pool::detach(client *c)
+{
+    // Jobs that were never started are dropped, but those already running
+    // still refer to the client
+    std::unique_lock<std::mutex> lock(m_mutex);
+    c->m_jobs.clear();
+    c->m_cv.wait(lock, [c]() { return c->m_running == 0; });
+    m_clients.erase(std::find(m_clients.begin(), m_clients.end(), c));
+}
+
+// Worker threads take the next job of the first client with queued jobs,
+// in the highest priority class and after the last client served in that
+// class.
+void worker_pool::worker_thread()
+{
+    perf_counters::add_thread();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        client *c = nullptr;
+        size_t const n = m_clients.size();
+        for (int p = 0; p < 2 && !c; ++p)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                size_t const i = (m_next[p] + k) % n;
+                if ((int)m_clients[i]->m_priority == p && !m_clients[i]->m_jobs.empty())
+                {
+                    c = m_clients[i];
+                    m_next[p] = i + 1;
+                    break;
+                }
+            }
+        }
+
+        if (!c)
+        {
+            if (m_quit)
+                break;
+            m_cv.wait(lock);
+            continue;
+        }
+
+        int const job = c->m_jobs.front();
+        c->m_jobs.pop_front();
+        ++c->m_running;
+
+        lock.unlock();
+        int const answer = c->m_handler(job);
+        lock.lock();
+
+        --c->m_running;
+        c->m_answers.push_back(answer);
+        c->m_cv.notify_all();
+    }
+}
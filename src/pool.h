@@ -0,0 +1,110 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The worker_pool class
+// ---------------------
+//
+// One set of worker threads for the whole process, as many as there are
+// cores, however many solvers exist. Each solver owns a client, to which
+// it pushes integer jobs and from which it pops the answers, as it used
+// to do with its own threads. Workers serve the interactive clients
+// before the batch ones, and take turns between the clients of the same
+// class, one job at a time, so that a solver with many jobs queued does
+// not hold back the others.
+//
+// Job handlers must not wait for other jobs, or they could starve the
+// pool of threads.
+//
+
+#include <lol/thread>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class worker_pool
+{
+public:
+    enum class priority
+    {
+        interactive,
+        batch,
+    };
+
+    class client
+    {
+    public:
+        // The handler runs a job on a worker thread and returns the answer
+        client(std::function<int(int)> const &handler,
+               priority p = priority::interactive);
+        ~client();
+
+        client(client const &) = delete;
+        client &operator =(client const &) = delete;
+
+        // Change the priority class of the jobs of this client
+        void set_priority(priority p);
+
+        void push(int job);
+
+        // Wait for the next answer, in order of completion
+        int pop();
+
+        // Push jobs 0 to count - 1 of the given kind at once, then wait
+        // for all of them and drop their answers
+        void run(int kind, int count);
+
+    private:
+        friend class worker_pool;
+
+        std::function<int(int)> m_handler;
+        priority m_priority;
+
+        // Protected by the pool mutex
+        std::deque<int> m_jobs, m_answers;
+        int m_running = 0;
+        std::condition_variable m_cv;
+    };
+
+    // Number of worker threads
+    static int size();
+
+    // Jobs pushed by client::run(), with the kind in the high bits and
+    // the index in the low 24 bits
+    static int job_kind(int job) { return job >> 24; }
+    static int job_index(int job) { return job & ((1 << 24) - 1); }
+
+private:
+    worker_pool();
+    ~worker_pool();
+
+    static worker_pool &get();
+
+    void attach(client *c);
+    void detach(client *c);
+    void worker_thread();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_quit = false;
+
+    // All clients, and where the round robin of each class resumes
+    std::vector<client *> m_clients;
+    size_t m_next[2] = { 0, 0 };
+
+    std::vector<lol::thread *> m_workers;
+};
@@ -0,0 +1,223 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::max
+
+#include "scheme.h"
+
+int eval_scheme::new_var(std::string const &name)
+{
+    m_vars.push_back(name);
+    return int(m_vars.size()) - 1;
+}
+
+eval_scheme::operand eval_scheme::emit(int kind, std::string const &name,
+                                       operand a, operand b, operand c)
+{
+    op o { decltype(op::kind)(kind), new_var(name), a, b, c };
+    m_ops.push_back(o);
+    return operand { operand::var, o.dst };
+}
+
+// Compute x^n using binary exponentiation, reusing known powers
+eval_scheme::operand eval_scheme::power(int n, std::vector<operand> &cache)
+{
+    if (n == 1)
+        return operand { operand::x, 0 };
+
+    if (int(cache.size()) <= n)
+        cache.resize(n + 1, operand { operand::x, -1 });
+
+    if (cache[n].index < 0)
+    {
+        std::string const name = "x" + std::to_string(n);
+        if (n % 2)
+            cache[n] = emit(op::mul, name, power(n - 1, cache), power(1, cache));
+        else
+        {
+            auto half = power(n / 2, cache);
+            cache[n] = emit(op::mul, name, half, half);
+        }
+    }
+
+    return cache[n];
+}
+
+// Evaluate Σ coeffs[k]·x^k with Horner’s scheme in a new variable
+eval_scheme::operand eval_scheme::chain(std::vector<int> const &coeffs, operand x,
+                                        std::string const &name)
+{
+    int const n = int(coeffs.size()) - 1;
+    operand ret { operand::coeff, coeffs[n] };
+
+    for (int k = n - 1; k >= 0; --k)
+    {
+        operand const c { operand::coeff, coeffs[k] };
+        if (k == n - 1)
+            ret = emit(op::muladd, name, ret, x, c);
+        else
+            m_ops.push_back(op { op::muladd, ret.index, ret, x, c });
+    }
+
+    return ret;
+}
+
+eval_scheme eval_scheme::horner(int degree)
+{
+    eval_scheme s("Horner", degree);
+    operand const x { operand::x, 0 };
+
+    if (degree > 0)
+    {
+        // Keep the familiar “u = c; u = u * x + c; …” form
+        auto u = s.emit(op::set, "u", operand { operand::coeff, degree });
+        for (int j = degree - 1; j >= 0; --j)
+            s.m_ops.push_back(op { op::muladd, u.index, u, x, operand { operand::coeff, j } });
+        s.m_result = u;
+    }
+
+    return s;
+}
+
+eval_scheme eval_scheme::split_horner(int degree)
+{
+    eval_scheme s("second-order Horner", degree);
+    operand const x { operand::x, 0 };
+
+    if (degree > 0)
+    {
+        std::vector<int> even, odd;
+        for (int j = 0; j <= degree; ++j)
+            (j % 2 ? odd : even).push_back(j);
+
+        std::vector<operand> cache;
+        operand const x2 = degree >= 2 ? s.power(2, cache) : x;
+        auto e = s.chain(even, x2, "e");
+        auto o = s.chain(odd, x2, "o");
+        s.m_result = s.emit(op::muladd, "u", o, x, e);
+    }
+
+    return s;
+}
+
+eval_scheme eval_scheme::estrin(int degree)
+{
+    eval_scheme s = mixed(degree, 2);
+    s.m_name = "Estrin";
+    return s;
+}
+
+eval_scheme eval_scheme::mixed(int degree, int block)
+{
+    eval_scheme s("mixed Horner/Estrin with blocks of " + std::to_string(block), degree);
+    operand const x { operand::x, 0 };
+    std::vector<operand> cache;
+
+    // Evaluate each block with Horner’s scheme
+    std::vector<operand> level;
+    for (int i = 0; i * block <= degree; ++i)
+    {
+        std::vector<int> coeffs;
+        for (int j = i * block; j <= std::min(degree, i * block + block - 1); ++j)
+            coeffs.push_back(j);
+        level.push_back(s.chain(coeffs, x, "p" + std::to_string(i)));
+    }
+
+    // Combine pairs of blocks with increasing powers of x
+    for (int k = block, l = 0; level.size() > 1; k *= 2, ++l)
+    {
+        auto const xk = s.power(k, cache);
+        std::string const prefix(1, char('q' + l));
+
+        std::vector<operand> next;
+        for (size_t i = 0; i < level.size(); i += 2)
+        {
+            if (i + 1 < level.size())
+                next.push_back(s.emit(op::muladd, prefix + std::to_string(i / 2),
+                                      level[i + 1], xk, level[i]));
+            else
+                next.push_back(level[i]);
+        }
+        level = next;
+    }
+
+    s.m_result = level[0];
+    return s;
+}
+
+std::vector<eval_scheme> eval_scheme::candidates(int degree)
+{
+    std::vector<eval_scheme> ret { horner(degree) };
+
+    if (degree >= 2)
+    {
+        ret.push_back(split_horner(degree));
+        ret.push_back(estrin(degree));
+    }
+
+    for (int block = 3; block <= degree; ++block)
+        ret.push_back(mixed(degree, block));
+
+    return ret;
+}
+
+int eval_scheme::op_count() const
+{
+    int ret = 0;
+    for (auto const &o : m_ops)
+        ret += o.kind == op::set ? 0 : 1;
+    return ret;
+}
+
+int eval_scheme::schedule(cost_model const &model) const
+{
+    std::vector<int> ready(m_vars.size(), 0);
+    std::vector<int> issued;
+
+    auto get = [&](operand const &o)
+    {
+        return o.kind == operand::var ? ready[o.index] : 0;
+    };
+
+    // Issue each operation as soon as its operands are ready and a port
+    // is free; earlier cycles may be backfilled, as an out-of-order core
+    // would do.
+    for (auto const &o : m_ops)
+    {
+        int t = std::max(get(o.a), o.kind == op::set ? 0 : get(o.b));
+        if (o.kind == op::muladd)
+            t = std::max(t, get(o.c));
+
+        if (o.kind == op::set)
+        {
+            ready[o.dst] = t;
+            continue;
+        }
+
+        for (;; ++t)
+        {
+            if (int(issued.size()) <= t)
+                issued.resize(t + 1, 0);
+            if (issued[t] < model.ports)
+                break;
+        }
+
+        ++issued[t];
+        ready[o.dst] = t + model.latency;
+    }
+
+    return get(m_result);
+}
@@ -0,0 +1,101 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The eval_scheme class
+// ---------------------
+//
+// A polynomial evaluation scheme is a short straight-line program made of
+// multiplications and additions on x and the polynomial coefficients. It
+// only depends on the degree, not on the coefficient values, so that the
+// same scheme can be printed as C code, evaluated in any native type for
+// error analysis, and scheduled on a simple machine model.
+//
+
+#include <string>
+#include <vector>
+
+enum class scheme_kind
+{
+    horner,
+    split_horner, // second-order Horner: even and odd parts in x²
+    estrin,
+    mixed,        // Horner blocks combined with Estrin’s scheme
+};
+
+// A very simple machine model: every operation (mul, add or fused
+// multiply-add) has the same latency, and a fixed number of them can be
+// issued each cycle.
+struct cost_model
+{
+    int latency = 4;
+    int ports = 2;
+};
+
+class eval_scheme
+{
+public:
+    struct operand
+    {
+        enum { x, coeff, var } kind;
+        int index;
+    };
+
+    struct op
+    {
+        enum { set, mul, add, muladd } kind;
+        int dst;
+        operand a, b, c; // dst = a, a * b, a + b, or a * b + c
+    };
+
+    static eval_scheme horner(int degree);
+    static eval_scheme split_horner(int degree);
+    static eval_scheme estrin(int degree);
+    // Blocks of “block” coefficients are evaluated with Horner’s scheme,
+    // then combined using powers of x^block.
+    static eval_scheme mixed(int degree, int block);
+
+    // Build all the schemes worth trying for this degree
+    static std::vector<eval_scheme> candidates(int degree);
+
+    std::string const &name() const { return m_name; }
+    int degree() const { return m_degree; }
+    std::vector<op> const &ops() const { return m_ops; }
+    std::vector<std::string> const &vars() const { return m_vars; }
+    operand result() const { return m_result; }
+
+    // Count arithmetic operations, fused multiply-adds counting as one
+    int op_count() const;
+
+    // Estimated latency of one call in cycles, using greedy list
+    // scheduling on the machine model
+    int schedule(cost_model const &model) const;
+
+private:
+    eval_scheme(std::string const &name, int degree)
+      : m_name(name), m_degree(degree) {}
+
+    int new_var(std::string const &name);
+    operand emit(int kind, std::string const &name,
+                 operand a, operand b = {}, operand c = {});
+    operand power(int n, std::vector<operand> &cache);
+    operand chain(std::vector<int> const &coeffs, operand x,
+                  std::string const &name);
+
+    std::string m_name;
+    int m_degree;
+    std::vector<op> m_ops;
+    std::vector<std::string> m_vars;
+    operand m_result { operand::coeff, 0 };
+};
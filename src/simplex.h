@@ -0,0 +1,225 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "matrix.h"
+
+/*
+ * Linear programs with few variables and many constraints:
+ *   minimise cᵀx subject to a_iᵀx ≤ b_i, with x free
+ * This is the shape of discrete minimax problems, with one constraint per
+ * grid point and side. The revised simplex method is applied to the dual
+ *   minimise bᵀy subject to Σ y_i·a_i = -c, y ≥ 0
+ * whose basis only has as many columns as there are variables, and x is
+ * recovered from the simplex multipliers. Constraints may be added after
+ * solving; the current basis stays feasible, so solving again resumes
+ * from where the previous solution left off.
+ */
+
+template<typename T>
+class linear_program
+{
+public:
+    enum class status
+    {
+        optimal,
+        infeasible,
+        unbounded,
+        iteration_limit,
+    };
+
+    linear_program(size_t vars)
+      : m_vars(vars),
+        m_objective(vars),
+        m_inverse(vars)
+    {
+    }
+
+    void set_objective(std::vector<T> const &c)
+    {
+        assert(c.size() == m_vars);
+        m_objective = c;
+        m_phase = 0;
+    }
+
+    // aᵀx ≤ b
+    void add_constraint(std::vector<T> const &a, T const &b)
+    {
+        assert(a.size() == m_vars);
+        m_rows.push_back(a);
+        m_rhs.push_back(b);
+    }
+
+    // aᵀx = b
+    void add_equality(std::vector<T> const &a, T const &b)
+    {
+        add_constraint(a, b);
+        std::vector<T> neg(a);
+        for (auto &x : neg)
+            x = -x;
+        add_constraint(neg, -b);
+    }
+
+    size_t constraints() const { return m_rows.size(); }
+
+    // Values below epsilon count as zero when pricing and in ratio tests
+    status solve(T const &epsilon, int max_iterations)
+    {
+        if (m_phase == 0)
+            start();
+
+        for (int iteration = 0; iteration < max_iterations; ++iteration)
+        {
+            // Simplex multipliers π = c_Bᵀ·B⁻¹
+            for (size_t j = 0; j < m_vars; ++j)
+            {
+                m_pi[j] = T(0);
+                for (size_t k = 0; k < m_vars; ++k)
+                    m_pi[j] += cost(m_basis[k]) * m_inverse[k][j];
+            }
+
+            // Entering column: most negative reduced cost; artificial
+            // columns never re-enter
+            int entering = -1;
+            T best = -epsilon;
+            for (size_t i = 0; i < m_rows.size(); ++i)
+            {
+                T d = cost((int)i);
+                for (size_t j = 0; j < m_vars; ++j)
+                    d -= m_pi[j] * m_sign[j] * m_rows[i][j];
+                if (d < best)
+                {
+                    best = d;
+                    entering = (int)i;
+                }
+            }
+
+            if (entering < 0)
+            {
+                if (m_phase == 2)
+                {
+                    // x = S·π, undoing the row sign changes
+                    for (size_t j = 0; j < m_vars; ++j)
+                        m_solution[j] = m_sign[j] * m_pi[j];
+                    return status::optimal;
+                }
+
+                // End of phase 1: the artificial columns must all be zero
+                for (size_t k = 0; k < m_vars; ++k)
+                    if (m_basis[k] < 0 && m_values[k] > epsilon)
+                        return status::infeasible;
+                m_phase = 2;
+                continue;
+            }
+
+            // Direction u = B⁻¹·a, then the ratio test. An artificial
+            // column still in the basis is at zero and leaves at once.
+            std::vector<T> u(m_vars);
+            for (size_t k = 0; k < m_vars; ++k)
+            {
+                u[k] = T(0);
+                for (size_t j = 0; j < m_vars; ++j)
+                    u[k] += m_inverse[k][j] * m_sign[j] * m_rows[entering][j];
+            }
+
+            int leaving = -1;
+            T ratio(0);
+            for (size_t k = 0; k < m_vars; ++k)
+            {
+                bool const artificial = m_phase == 2 && m_basis[k] < 0;
+                if (artificial ? fabs(u[k]) <= epsilon : u[k] <= epsilon)
+                    continue;
+                T const r = artificial ? T(0) : m_values[k] / u[k];
+                if (leaving < 0 || r < ratio)
+                {
+                    leaving = (int)k;
+                    ratio = r;
+                }
+            }
+
+            if (leaving < 0)
+                return status::unbounded;
+
+            pivot((size_t)leaving, u, ratio);
+            m_basis[leaving] = entering;
+        }
+
+        return status::iteration_limit;
+    }
+
+    std::vector<T> const &solution() const { return m_solution; }
+
+private:
+    // Artificial column k is numbered -1 - k
+    T cost(int column) const
+    {
+        if (column < 0)
+            return m_phase == 1 ? T(1) : T(0);
+        return m_phase == 1 ? T(0) : m_rhs[column];
+    }
+
+    void start()
+    {
+        m_sign.resize(m_vars);
+        m_values.resize(m_vars);
+        m_basis.resize(m_vars);
+        m_pi.resize(m_vars);
+        m_solution.resize(m_vars);
+
+        // Rows are negated where needed so that the right-hand side -c is
+        // nonnegative, and the artificial columns form the first basis.
+        m_inverse.init(T(1));
+        for (size_t k = 0; k < m_vars; ++k)
+        {
+            m_sign[k] = m_objective[k] > T(0) ? T(-1) : T(1);
+            m_values[k] = fabs(m_objective[k]);
+            m_basis[k] = -1 - (int)k;
+        }
+        m_phase = 1;
+    }
+
+    void pivot(size_t leaving, std::vector<T> const &u, T const &ratio)
+    {
+        T const inv = T(1) / u[leaving];
+        for (size_t j = 0; j < m_vars; ++j)
+            m_inverse[leaving][j] *= inv;
+
+        for (size_t k = 0; k < m_vars; ++k)
+        {
+            if (k == leaving)
+                continue;
+            for (size_t j = 0; j < m_vars; ++j)
+                m_inverse[k][j] -= u[k] * m_inverse[leaving][j];
+            m_values[k] -= ratio * u[k];
+        }
+        m_values[leaving] = ratio;
+    }
+
+    size_t m_vars;
+    std::vector<T> m_objective;
+    std::vector<std::vector<T>> m_rows;
+    std::vector<T> m_rhs;
+
+    // 0 before the first solve, then 1 or 2 for the simplex phase
+    int m_phase = 0;
+
+    // Row signs, basis columns, their values, and the basis inverse
+    std::vector<T> m_sign, m_values;
+    std::vector<int> m_basis;
+    linear_system<T> m_inverse;
+
+    std::vector<T> m_pi, m_solution;
+};
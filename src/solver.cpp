@@ -14,41 +14,37 @@
 #   include "config.h"
 #endif
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <iomanip>
-#include <thread>
 
 #include <lol/real>
 #include <lol/math>
 
 #include "matrix.h"
+#include "perf.h"
 #include "solver.h"
 
 using lol::real;
 
-remez_solver::remez_solver()
-{
-    /* Spawn worker threads */
-    for (unsigned int i = 0; i < std::thread::hardware_concurrency(); ++i)
-    {
-        auto th = new thread(std::bind(&remez_solver::worker_thread, this));
-        m_workers.push_back(th);
-    }
-}
-
-remez_solver::~remez_solver()
-{
-    /* Signal worker threads to quit, wait for worker threads to answer,
-     * and kill worker threads. */
-    for (auto worker : m_workers)
-        (void)worker, m_questions.push(-1);
+/* Error plotting: samples per worker job, and jobs per batch. Two batches
+ * are in flight so that writing one overlaps with computing the next. */
+static int const plot_chunk = 256;
+static int const plot_jobs = 16;
 
-    for (auto worker : m_workers)
-        (void)worker, m_answers.pop();
+/* Parallel k-section: point j of bracket i is job zero_point_job + i * k + j
+ * when looking for zeros, and extremum_point_job + i * k + j when looking
+ * for extrema. Superlinear root finders converge in a handful of rounds
+ * anyway, and only gain from many points per bracket. */
+static int const zero_point_job = 1 << 24;
+static int const extremum_point_job = 2 << 24;
+static int const min_section_zeros = 12;
+static int const min_section_extrema = 4;
 
-    for (auto worker : m_workers)
-        delete worker;
+remez_solver::remez_solver()
+  : m_pool([this](int i) { return do_job(i); })
+{
 }
 
 void remez_solver::set_order(int order)
@@ -69,13 +65,24 @@ void remez_solver::set_range(real a, real b)
 
 void remez_solver::set_func(expression const &expr)
 {
-    m_func = expr;
+    m_func = [expr](real const &x) { return expr.eval(x); };
 }
 
 void remez_solver::set_weight(expression const &expr)
 {
     m_has_weight = !expr.is_constant();
-    m_weight = expr;
+    m_weight = [expr](real const &x) { return expr.eval(x); };
+}
+
+void remez_solver::set_func(std::function<real(real const &)> const &func)
+{
+    m_func = func;
+}
+
+void remez_solver::set_weight(std::function<real(real const &)> const &func)
+{
+    m_has_weight = true;
+    m_weight = func;
 }
 
 void remez_solver::set_root_finder(root_finder rf)
@@ -83,6 +90,11 @@ void remez_solver::set_root_finder(root_finder rf)
     m_rf = rf;
 }
 
+void remez_solver::set_priority(worker_pool::priority p)
+{
+    m_pool.set_priority(p);
+}
+
 bool remez_solver::check_sanity() const
 {
     // Check that the weight function has no zeroes
@@ -94,7 +106,7 @@ bool remez_solver::check_sanity() const
         for (int i = 0; i <= steps; ++i)
         {
             real x = m_xmin + real(i) * delta;
-            real fx = m_weight.eval(x);
+            real fx = m_weight(x);
             if (fx.is_zero())
             {
                 std::cout << "Error: weight function is zero at x = " << x << '\n';
@@ -120,6 +132,7 @@ void remez_solver::do_init()
     m_k1 = (m_xmax + m_xmin) / 2;
     m_k2 = (m_xmax - m_xmin) / 2;
     m_epsilon = pow((real)10, (real)-(m_digits + 2));
+    m_error = 0;
 
     if (show_debug)
         std::cout << std::setprecision(m_digits) << "[debug] k1: " << m_k1
@@ -128,6 +141,56 @@ void remez_solver::do_init()
     remez_init();
 }
 
+bool remez_solver::do_init(std::vector<real> const &chebyshev)
+{
+    do_init();
+
+    m_chebyshev = chebyshev;
+    m_chebyshev.resize(m_order + 1);
+    m_estimate = polynomial<real>();
+    for (int n = 0; n < m_order + 1; n++)
+        m_estimate += m_chebyshev[n] * polynomial<real>::chebyshev(n);
+
+    /* Sample the error, denser near the ends where the extrema gather */
+    int const samples = 64 * (m_order + 2);
+    std::vector<real> xs, errs;
+    m_error = 0;
+    for (int i = 0; i <= samples; ++i)
+    {
+        xs.push_back(-cos(real::R_PI() * i / samples));
+        errs.push_back((eval_estimate(xs[i]) - eval_func(xs[i])) / eval_weight(xs[i]));
+        m_error = max(m_error, fabs(errs[i]));
+    }
+
+    /* Zeros by linear interpolation between samples of opposite signs,
+     * and one control point at the largest error between two zeros */
+    std::vector<real> zeros, control;
+    int best = 0;
+    for (int i = 1; i <= samples; ++i)
+    {
+        if ((errs[i - 1] * errs[i]).is_negative() || (errs[i].is_zero() && i < samples))
+        {
+            control.push_back(xs[best]);
+            zeros.push_back(xs[i - 1] + (xs[i] - xs[i - 1]) * errs[i - 1] / (errs[i - 1] - errs[i]));
+            best = i;
+        }
+        else if (fabs(errs[i]) > fabs(errs[best]))
+            best = i;
+    }
+    control.push_back(xs[best]);
+
+    if ((int)zeros.size() != m_order + 1)
+    {
+        m_zeros.clear();
+        m_control.clear();
+        return false;
+    }
+
+    m_zeros = zeros;
+    m_control = control;
+    return true;
+}
+
 bool remez_solver::do_step()
 {
     real const old_error = m_error;
@@ -135,12 +198,13 @@ bool remez_solver::do_step()
     find_extrema();
     remez_step();
 
-    if (m_error >= (real)0
-         && fabs(m_error - old_error) < m_error * m_epsilon)
-        return false;
+    /* Even after the last step, find the zeros of the new estimate, so
+     * that they can be plotted with it. */
+    bool const done = m_error >= (real)0
+                       && fabs(m_error - old_error) < m_error * m_epsilon;
 
     find_zeros();
-    return true;
+    return !done;
 }
 
 polynomial<real> remez_solver::get_estimate() const
@@ -152,6 +216,101 @@ polynomial<real> remez_solver::get_estimate() const
     return m_estimate.eval(q);
 }
 
+void remez_solver::plot_error(std::ostream &os, format fmt, int samples, int index)
+{
+    int const batch = plot_chunk * plot_jobs;
+
+    m_plot_samples = samples;
+    m_plot_start.resize(2 * plot_jobs);
+    m_plot_values.resize(2 * batch);
+
+    if (fmt == format::csv && index == 0)
+        os << "index,x,error\n";
+    else if (fmt == format::gnuplot)
+        os << (index ? "\n\n" : "") << "# x error (index " << index << ")\n";
+    os << std::setprecision(17);
+
+    /* Jobs 2000 and above compute one chunk of samples each; slot s of
+     * buffer b is job 2000 + b * plot_jobs + s. */
+    auto submit = [&](int b, int first)
+    {
+        for (int s = 0; s < plot_jobs; ++s)
+        {
+            m_plot_start[b * plot_jobs + s] = first + s * plot_chunk;
+            m_pool.push(2000 + b * plot_jobs + s);
+        }
+    };
+
+    int const batches = (samples + batch - 1) / batch;
+    int done[2] = { 0, 0 };
+
+    submit(0, 0);
+    for (int n = 0; n < batches; ++n)
+    {
+        int const b = n & 1;
+        if (n + 1 < batches)
+            submit(b ^ 1, (n + 1) * batch);
+
+        while (done[b] < plot_jobs)
+            ++done[(m_pool.pop() - 2000) / plot_jobs];
+        done[b] = 0;
+
+        int const first = n * batch;
+        int const count = std::min(batch, samples - first);
+        for (int k = 0; k < count; ++k)
+        {
+            real const x = m_xmin + (m_xmax - m_xmin) * real(first + k) / real(samples - 1);
+            if (fmt == format::csv)
+                os << index << ',' << double(x) << ',' << double(m_plot_values[b * batch + k]) << '\n';
+            else
+                os << double(x) << ' ' << double(m_plot_values[b * batch + k]) << '\n';
+        }
+    }
+
+    os.flush();
+}
+
+void remez_solver::plot_script(std::ostream &os, format fmt, std::string const &data, int blocks) const
+{
+    int const last = blocks - 1;
+
+    os << "# Generated by lolremez; run with “gnuplot -p <this file>”\n";
+    os << "set title \"Weighted error of the degree " << m_order << " approximation\"\n";
+    os << "set xlabel \"x\"\nset ylabel \"error\"\nset grid\nset key outside\n";
+    if (fmt == format::csv)
+        os << "set datafile separator \",\"\n";
+    os << std::setprecision(17);
+
+    /* Control points are where the error equioscillates, zeros are where
+     * the polynomial interpolates the function. */
+    os << "$control << EOD\n";
+    for (auto const &x : m_control)
+        os << double(x * m_k2 + m_k1) << ' '
+           << double((eval_estimate(x) - eval_func(x)) / eval_weight(x)) << '\n';
+    os << "EOD\n$zeros << EOD\n";
+    for (auto const &x : m_zeros)
+        os << double(x * m_k2 + m_k1) << " 0\n";
+    os << "EOD\n\n";
+
+    os << "plot ";
+    if (fmt == format::csv)
+    {
+        if (last > 0)
+            os << "for [i=0:" << last - 1 << "] \"" << data << "\" using 2:($1 == i ? $3 : 1/0) "
+               << "with lines lc rgb \"gray\" notitle, \\\n     ";
+        os << "\"" << data << "\" using 2:($1 == " << last << " ? $3 : 1/0) with lines lw 2 title \"error\", \\\n";
+    }
+    else
+    {
+        if (last > 0)
+            os << "for [i=0:" << last - 1 << "] \"" << data << "\" index i using 1:2 "
+               << "with lines lc rgb \"gray\" notitle, \\\n     ";
+        os << "\"" << data << "\" index " << last << " using 1:2 with lines lw 2 title \"error\", \\\n";
+    }
+    os << "     $control using 1:2 with points pt 7 title \"control points\", \\\n";
+    os << "     $zeros using 1:2 with points pt 6 title \"zeros\"\n";
+}
+
 /*
  * This is basically the first Remez step: we solve a system of
  * order N+1 and get a good initial polynomial estimate.
@@ -194,12 +353,14 @@ void remez_solver::remez_init()
 
     /* Compute new Chebyshev estimate */
     m_estimate = polynomial<real>();
+    m_chebyshev.assign(m_order + 1, real::R_0());
     for (int n = 0; n < m_order + 1; n++)
     {
         real weight = 0;
         for (int i = 0; i < m_order + 1; i++)
             weight += system[n][i] * fxn[i];
 
+        m_chebyshev[n] = weight;
         m_estimate += weight * polynomial<real>::chebyshev(n);
     }
 }
@@ -211,6 +372,7 @@ void remez_solver::remez_init()
 void remez_solver::remez_step()
 {
     timer t;
+    perf_counters::scope counting(perf_counters::phase::step);
 
     /* Pick up x_i where error will be 0 and compute f(x_i) */
     std::vector<real> fxn;
@@ -239,12 +401,14 @@ void remez_solver::remez_step()
 
     /* Compute new polynomial estimate */
     m_estimate = polynomial<real>();
+    m_chebyshev.assign(m_order + 1, real::R_0());
     for (int n = 0; n < m_order + 1; n++)
     {
         real weight = 0;
         for (int i = 0; i < m_order + 2; i++)
             weight += system[n][i] * fxn[i];
 
+        m_chebyshev[n] = weight;
         m_estimate += weight * polynomial<real>::chebyshev(n);
     }
 
@@ -261,12 +425,27 @@ void remez_solver::remez_step()
  * Find m_order + 1 zeros of the error function. No need to compute the
  * relative error: its zeros are at the same place as the absolute error!
  *
- * The algorithm used here can be selected at runtime.
+ * The algorithm used here can be selected at runtime. When there are fewer
+ * brackets than workers, the idle workers help search each bracket.
  */
 void remez_solver::find_zeros()
 {
     timer t;
+    perf_counters::scope counting(perf_counters::phase::zeros);
+
+    bool const linear = m_rf == root_finder::bisect || m_rf == root_finder::regula_falsi;
+    int const k = worker_pool::size() / (m_order + 1);
+    if (k >= (linear ? 2 : min_section_zeros))
+        find_zeros_ksection(k);
+    else
+        find_zeros_serial();
+
+    if (show_stats)
+        std::cout << " -:- timing for zeros: " << (t.get() * 1000.f) << " ms\n";
+}
 
+void remez_solver::find_zeros_serial()
+{
     /* Initialise an [a,b] bracket for each zero we try to find */
     for (int i = 0; i < m_order + 1; i++)
     {
@@ -280,13 +459,13 @@ void remez_solver::find_zeros()
         b.err = eval_estimate(b.x) - eval_func(b.x);
         c.err = 0;
 
-        m_questions.push(i);
+        m_pool.push(i);
     }
 
     /* Watch all brackets for updates from worker threads */
     for (int finished = 0; finished < m_order + 1; )
     {
-        int i = m_answers.pop();
+        int i = m_pool.pop();
 
         point const &a = m_zeros_state[i][0];
         point const &b = m_zeros_state[i][1];
@@ -299,11 +478,109 @@ void remez_solver::find_zeros()
             continue;
         }
 
-        m_questions.push(i);
+        m_pool.push(i);
     }
+}
 
-    if (show_stats)
-        std::cout << " -:- timing for zeros: " << (t.get() * 1000.f) << " ms\n";
+// Each round evaluates k points of a bracket at once: the root finder’s
+// estimate c, and points halving the distance from either end to c, so
+// that the bracket shrinks at least by half, and much more when c is close
+// to the zero. With bisection, the k points split the bracket evenly into
+// k + 1 parts.
+void remez_solver::find_zeros_ksection(int k)
+{
+    m_section.resize((m_order + 1) * k);
+
+    auto submit = [&](int i)
+    {
+        point const &a = m_zeros_state[i][0];
+        point const &b = m_zeros_state[i][1];
+
+        bool const bisect = m_rf == root_finder::bisect;
+        real c = a.x - a.err * (b.x - a.x) / (b.err - a.err);
+        if (bisect || !(c > a.x && c < b.x))
+            c = (a.x + b.x) / 2;
+
+        for (int j = 0; j < k; ++j)
+        {
+            // Odd points are on the b side, even points on the a side
+            int const m = (j + 1) / 2, n = j % 2 ? k / 2 : (k - 1) / 2;
+            real const end = j % 2 ? b.x : a.x;
+            m_section[i * k + j].x = bisect ? a.x + (b.x - a.x) * real(j + 1) / real(k + 1)
+                                   : j == 0 ? c : c + (end - c) * ldexp(real::R_1(), m - n - 1);
+            m_pool.push(zero_point_job + i * k + j);
+        }
+    };
+
+    for (int i = 0; i < m_order + 1; i++)
+    {
+        point &a = m_zeros_state[i][0];
+        point &b = m_zeros_state[i][1];
+
+        a.x = m_control[i];
+        a.err = eval_estimate(a.x) - eval_func(a.x);
+        b.x = m_control[i + 1];
+        b.err = eval_estimate(b.x) - eval_func(b.x);
+
+        submit(i);
+    }
+
+    std::vector<int> done(m_order + 1, 0);
+    for (int finished = 0; finished < m_order + 1; )
+    {
+        int const i = (m_pool.pop() - zero_point_job) / k;
+        if (++done[i] < k)
+            continue;
+        done[i] = 0;
+
+        point &a = m_zeros_state[i][0];
+        point &b = m_zeros_state[i][1];
+
+        std::vector<point> pts(m_section.begin() + i * k, m_section.begin() + (i + 1) * k);
+        pts.push_back(a);
+        pts.push_back(b);
+        std::sort(pts.begin(), pts.end(),
+                  [](point const &p, point const &q) { return p.x < q.x; });
+
+        // The first sign change is the new bracket; a retained end has
+        // its error halved as in the Illinois algorithm, except for plain
+        // regula falsi.
+        bool exact = false;
+        for (size_t n = 0; n + 1 < pts.size(); ++n)
+        {
+            if (pts[n].err.is_zero() || pts[n + 1].err.is_zero())
+            {
+                m_zeros[i] = pts[n].err.is_zero() ? pts[n].x : pts[n + 1].x;
+                exact = true;
+                break;
+            }
+
+            if ((pts[n].err * pts[n + 1].err).is_negative())
+            {
+                bool const keep_a = pts[n].x == a.x, keep_b = pts[n + 1].x == b.x;
+                a = pts[n];
+                b = pts[n + 1];
+                if (m_rf != root_finder::regula_falsi)
+                {
+                    if (keep_a)
+                        a.err /= 2;
+                    if (keep_b)
+                        b.err /= 2;
+                }
+                break;
+            }
+        }
+
+        if (exact || fabs(a.x - b.x) <= m_epsilon)
+        {
+            if (!exact)
+                m_zeros[i] = (a.x + b.x) / 2;
+            ++finished;
+            continue;
+        }
+
+        submit(i);
+    }
 }
 
 
@@ -317,15 +594,32 @@ void remez_solver::find_zeros()
 //
 // The algorithm used here is successive parabolic interpolation. FIXME: we
 // could use Brent’s method instead, which combines parabolic interpolation
-// and golden ratio search and has superlinear convergence.
+// and golden ratio search and has superlinear convergence. As for zeros,
+// idle workers help search each bracket when there are only a few.
 void remez_solver::find_extrema()
 {
     timer t;
+    perf_counters::scope counting(perf_counters::phase::extrema);
 
     m_control[0] = -1;
     m_control[m_order + 1] = 1;
     m_error = 0;
 
+    int const k = worker_pool::size() / (m_order + 2);
+    if (k >= min_section_extrema)
+        find_extrema_ksection(k);
+    else
+        find_extrema_serial();
+
+    if (show_stats)
+        std::cout << " -:- timing for extrema: " << (t.get() * 1000.f) << " ms\n";
+
+    if (show_debug)
+        std::cout << "[debug] error: " << std::setprecision(m_digits) << m_error << "\n";
+}
+
+void remez_solver::find_extrema_serial()
+{
     /* Initialise an [a,b,c] bracket for each extremum we try to find */
     for (int i = 0; i < m_order + 2; i++)
     {
@@ -341,13 +635,13 @@ void remez_solver::find_extrema()
         b.err = eval_error(b.x);
         c.err = eval_error(c.x);
 
-        m_questions.push(i + 1000);
+        m_pool.push(i + 1000);
     }
 
     /* Watch all brackets for updates from worker threads */
     for (int finished = 0; finished < m_order + 2; )
     {
-        int i = m_answers.pop() - 1000;
+        int i = m_pool.pop() - 1000;
 
         point const &a = m_extrema_state[i][0];
         point const &b = m_extrema_state[i][1];
@@ -362,137 +656,250 @@ void remez_solver::find_extrema()
             continue;
         }
 
-        m_questions.push(i + 1000);
+        m_pool.push(i + 1000);
     }
+}
 
-    if (show_stats)
-        std::cout << " -:- timing for extrema: " << (t.get() * 1000.f) << " ms\n";
+// Each round evaluates the parabolic interpolation point and k - 1 points
+// splitting the [a,b] bracket evenly, then brackets the largest error by
+// its neighbours, shrinking the bracket by at least a factor of k / 2.
+void remez_solver::find_extrema_ksection(int k)
+{
+    m_section.resize((m_order + 2) * k);
 
-    if (show_debug)
-        std::cout << "[debug] error: " << std::setprecision(m_digits) << m_error << "\n";
+    auto submit = [&](int i)
+    {
+        point const &a = m_extrema_state[i][0];
+        point const &b = m_extrema_state[i][1];
+        point const &c = m_extrema_state[i][2];
+
+        real const d1 = c.x - a.x, d2 = c.x - b.x;
+        real const k1 = d1 * (c.err - b.err);
+        real const k2 = d2 * (c.err - a.err);
+        real d = c.x - (d1 * k1 - d2 * k2) / (k1 - k2) / 2;
+        if (!(d > a.x && d < b.x))
+            d = (a.x + b.x) / 2;
+
+        for (int j = 0; j < k; ++j)
+        {
+            m_section[i * k + j].x = j == 0 ? d : a.x + (b.x - a.x) * real(j) / real(k);
+            m_pool.push(extremum_point_job + i * k + j);
+        }
+    };
+
+    for (int i = 0; i < m_order + 2; i++)
+    {
+        point &a = m_extrema_state[i][0];
+        point &b = m_extrema_state[i][1];
+        point &c = m_extrema_state[i][2];
+
+        a.x = i == 0 ? (real)-1 : m_zeros[i - 1];
+        b.x = i == m_order + 1 ? (real)1 : m_zeros[i];
+        c.x = a.x + (b.x - a.x) * real(rand(0.4f, 0.6f));
+
+        a.err = eval_error(a.x);
+        b.err = eval_error(b.x);
+        c.err = eval_error(c.x);
+
+        submit(i);
+    }
+
+    std::vector<int> done(m_order + 2, 0);
+    for (int finished = 0; finished < m_order + 2; )
+    {
+        int const i = (m_pool.pop() - extremum_point_job) / k;
+        if (++done[i] < k)
+            continue;
+        done[i] = 0;
+
+        point &a = m_extrema_state[i][0];
+        point &b = m_extrema_state[i][1];
+        point &c = m_extrema_state[i][2];
+
+        std::vector<point> pts(m_section.begin() + i * k, m_section.begin() + (i + 1) * k);
+        pts.push_back(a);
+        pts.push_back(b);
+        pts.push_back(c);
+        std::sort(pts.begin(), pts.end(),
+                  [](point const &p, point const &q) { return p.x < q.x; });
+
+        // Points may almost coincide, for instance the parabolic point and
+        // the midpoint, and then comparing their errors is only comparing
+        // rounding noise. Such points cannot bound the new bracket, so only
+        // the best of them is kept; merging points within epsilon / 8 of
+        // each other still lets the bracket shrink below epsilon.
+        std::vector<point> kept;
+        for (auto const &p : pts)
+        {
+            if (kept.empty() || p.x - kept.back().x > m_epsilon / 8)
+                kept.push_back(p);
+            else if (p.err > kept.back().err)
+                kept.back() = p;
+        }
+        pts.swap(kept);
+
+        size_t best = 0;
+        for (size_t n = 1; n < pts.size(); ++n)
+            if (pts[n].err > pts[best].err)
+                best = n;
+
+        a = pts[best > 0 ? best - 1 : 0];
+        b = pts[std::min(best + 1, pts.size() - 1)];
+        c = pts[best];
+
+        if (b.x - a.x <= m_epsilon)
+        {
+            m_control[i] = c.x;
+            if (c.err > m_error)
+                m_error = c.err;
+            ++finished;
+            continue;
+        }
+
+        submit(i);
+    }
 }
 
-real remez_solver::eval_estimate(real const &x)
+real remez_solver::eval_estimate(real const &x) const
 {
     return m_estimate.eval(x);
 }
 
-real remez_solver::eval_func(real const &x)
+real remez_solver::eval_func(real const &x) const
 {
-    return m_func.eval(x * m_k2 + m_k1);
+    return m_func(x * m_k2 + m_k1);
 }
 
-real remez_solver::eval_weight(real const &x)
+real remez_solver::eval_weight(real const &x) const
 {
-    return m_has_weight ? m_weight.eval(x * m_k2 + m_k1) : real(1);
+    return m_has_weight ? m_weight(x * m_k2 + m_k1) : real(1);
 }
 
-real remez_solver::eval_error(real const &x)
+real remez_solver::eval_error(real const &x) const
 {
     return fabs((eval_estimate(x) - eval_func(x)) / eval_weight(x));
 }
 
-// Worker threads handle jobs from the main thread, computing either a root finding step
-// or an extrema finding iteration step.
-void remez_solver::worker_thread()
+// Worker threads handle jobs from the main thread, computing either a root finding step,
+// an extrema finding iteration step, or one point of a k-section round.
+int remez_solver::do_job(int i)
 {
-    for (;;)
+    if (i >= extremum_point_job)
     {
-        int i = m_questions.pop();
-
-        if (i < 0)
+        // One point of a k-section round for an extremum
+        point &p = m_section[i - extremum_point_job];
+        p.err = eval_error(p.x);
+        return i;
+    }
+    else if (i >= zero_point_job)
+    {
+        // One point of a k-section round for a zero
+        point &p = m_section[i - zero_point_job];
+        p.err = eval_estimate(p.x) - eval_func(p.x);
+        return i;
+    }
+    else if (i < 1000)
+    {
+        // Root finding step
+        point &a = m_zeros_state[i][0];
+        point &b = m_zeros_state[i][1];
+        point &c = m_zeros_state[i][2];
+
+        auto old_c_err = c.err;
+
+        // Bisect method uses the midpoint. Other methods such as regula falsi (slow) and
+        // some improved versions use the “false position”.
+        if (m_rf == root_finder::bisect)
+            c.x = (a.x + b.x) / 2;
+        else
+            c.x = a.x - a.err * (b.x - a.x) / (b.err - a.err);
+        c.err = eval_estimate(c.x) - eval_func(c.x);
+
+        // pd is the point with a different error sign from c, ps has same sign
+        point *pd = &a, *ps = &b;
+        if (sign(a.err) * sign(c.err) > 0)
+            std::swap(pd, ps);
+
+        // Regula falsi variations tweak a.err or b.err for the next iteration
+        // when the computed error has the same sign as the last time.
+        if (sign(c.err) * sign(old_c_err) > 0)
         {
-            m_answers.push(i);
-            break;
+            switch (m_rf)
+            {
+            case root_finder::illinois:
+                // Illinois algorithm
+                pd->err /= 2;
+                break;
+            case root_finder::pegasus:
+                // Pegasus algorithm from doi:10.1007/BF01932959 by M. Dowell and P. Jarratt.
+                // “The philosophy of the method is to scale down the value fi-1 by the factor
+                // fi/(fi+fi+1) […]”.
+                pd->err *= old_c_err / (old_c_err + c.err);
+                break;
+            case root_finder::ford:
+                // Method 4 of https://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.53.8676
+                // by J. A. Ford
+                pd->err *= real::R_1() - c.err / ps->err - c.err / pd->err;
+                break;
+            default:
+                break;
+            }
         }
-        else if (i < 1000)
-        {
-            // Root finding step
-            point &a = m_zeros_state[i][0];
-            point &b = m_zeros_state[i][1];
-            point &c = m_zeros_state[i][2];
 
-            auto old_c_err = c.err;
+        // Either a or b becomes c
+        *ps = c;
 
-            // Bisect method uses the midpoint. Other methods such as regula falsi (slow) and
-            // some improved versions use the “false position”.
-            if (m_rf == root_finder::bisect)
-                c.x = (a.x + b.x) / 2;
-            else
-                c.x = a.x - a.err * (b.x - a.x) / (b.err - a.err);
-            c.err = eval_estimate(c.x) - eval_func(c.x);
+        return i;
+    }
+    else if (i < 2000)
+    {
+        // Extrema finding step
+        i -= 1000;
+
+        point &a = m_extrema_state[i][0];
+        point &b = m_extrema_state[i][1];
+        point &c = m_extrema_state[i][2];
+        point d;
 
-            // pd is the point with a different error sign from c, ps has same sign
-            point *pd = &a, *ps = &b;
-            if (sign(a.err) * sign(c.err) > 0)
-                std::swap(pd, ps);
+        real const d1 = c.x - a.x, d2 = c.x - b.x;
+        real const k1 = d1 * (c.err - b.err);
+        real const k2 = d2 * (c.err - a.err);
+        d.x = c.x - (d1 * k1 - d2 * k2) / (k1 - k2) / 2;
 
-            // Regula falsi variations tweak a.err or b.err for the next iteration
-            // when the computed error has the same sign as the last time.
-            if (sign(c.err) * sign(old_c_err) > 0)
-            {
-                switch (m_rf)
-                {
-                case root_finder::illinois:
-                    // Illinois algorithm
-                    pd->err /= 2;
-                    break;
-                case root_finder::pegasus:
-                    // Pegasus algorithm from doi:10.1007/BF01932959 by M. Dowell and P. Jarratt.
-                    // “The philosophy of the method is to scale down the value fi-1 by the factor
-                    // fi/(fi+fi+1) […]”.
-                    pd->err *= old_c_err / (old_c_err + c.err);
-                    break;
-                case root_finder::ford:
-                    // Method 4 of https://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.53.8676
-                    // by J. A. Ford
-                    pd->err *= real::R_1() - c.err / ps->err - c.err / pd->err;
-                    break;
-                default:
-                    break;
-                }
-            }
+        /* If parabolic interpolation failed, pick a number
+         * inbetween. */
+        if (d.x <= a.x || d.x >= b.x)
+            d.x = (a.x + b.x) / 2;
 
-            // Either a or b becomes c
-            *ps = c;
+        d.err = eval_error(d.x);
 
-            m_answers.push(i);
+        /* Update bracketing depending on the new point. */
+        if (d.err < c.err)
+        {
+            (d.x > c.x ? b : a) = d;
         }
-        else if (i < 2000)
+        else
         {
-            // Extrema finding step
-            i -= 1000;
-
-            point &a = m_extrema_state[i][0];
-            point &b = m_extrema_state[i][1];
-            point &c = m_extrema_state[i][2];
-            point d;
-
-            real const d1 = c.x - a.x, d2 = c.x - b.x;
-            real const k1 = d1 * (c.err - b.err);
-            real const k2 = d2 * (c.err - a.err);
-            d.x = c.x - (d1 * k1 - d2 * k2) / (k1 - k2) / 2;
-
-            /* If parabolic interpolation failed, pick a number
-             * inbetween. */
-            if (d.x <= a.x || d.x >= b.x)
-                d.x = (a.x + b.x) / 2;
-
-            d.err = eval_error(d.x);
+            (d.x > c.x ? a : b) = c;
+            c = d;
+        }
 
-            /* Update bracketing depending on the new point. */
-            if (d.err < c.err)
-            {
-                (d.x > c.x ? b : a) = d;
-            }
-            else
-            {
-                (d.x > c.x ? a : b) = c;
-                c = d;
-            }
+        return i + 1000;
+    }
+    else
+    {
+        // Error plotting: one chunk of samples
+        int const start = m_plot_start[i - 2000];
+        real *values = &m_plot_values[(i - 2000) * plot_chunk];
 
-            m_answers.push(i + 1000);
+        for (int k = 0; k < plot_chunk && start + k < m_plot_samples; ++k)
+        {
+            real const x = m_xmin + (m_xmax - m_xmin) * real(start + k) / real(m_plot_samples - 1);
+            real const t = (x - m_k1) / m_k2;
+            values[k] = (eval_estimate(t) - eval_func(t)) / eval_weight(t);
         }
+
+        return i;
     }
 }
 
@@ -21,10 +21,14 @@
 #include <lol/math>
 #include <lol/real>
 
+#include <functional>
+#include <ostream>
+#include <string>
 #include <vector>
 #include <array>
 
 #include "expression.h"
+#include "pool.h"
 
 enum class root_finder
 {
@@ -39,11 +43,11 @@ class remez_solver
 {
 public:
     remez_solver();
-    ~remez_solver();
 
     enum class format
     {
         gnuplot,
+        csv,
         cpp,
     };
 
@@ -52,16 +56,48 @@ public:
     void set_range(lol::real xmin, lol::real xmax);
     void set_func(expression const &expr);
     void set_weight(expression const &expr);
+    // Arbitrary functions, which must be safe to call from several threads
+    void set_func(std::function<lol::real(lol::real const &)> const &func);
+    void set_weight(std::function<lol::real(lol::real const &)> const &func);
     void set_root_finder(root_finder rf);
+    // Priority of this solver’s jobs in the shared worker pool
+    void set_priority(worker_pool::priority p);
+
+    int get_order() const { return m_order; }
+    lol::real get_xmin() const { return m_xmin; }
+    lol::real get_xmax() const { return m_xmax; }
 
     bool check_sanity() const;
 
     void do_init();
     bool do_step();
 
+    // Start from a given estimate, in the form returned by get_chebyshev(),
+    // instead of interpolating at Chebyshev nodes. The zeros and extrema of
+    // its error are located by sampling; returns false if there are not
+    // exactly order + 1 zeros, in which case do_step() should not be used.
+    bool do_init(std::vector<lol::real> const &chebyshev);
+
     lol::polynomial<lol::real> get_estimate() const;
+
+    // The estimate as Σ a_n·T_n(t) with t = (x - k1) / k2
+    std::vector<lol::real> const &get_chebyshev() const { return m_chebyshev; }
+    lol::real get_k1() const { return m_k1; }
+    lol::real get_k2() const { return m_k2; }
+
     lol::real get_error() const { return m_error; }
 
+    // Sample the weighted error of the current estimate at “samples” evenly
+    // spaced points. Samples are evaluated in parallel by the worker threads
+    // and streamed to “os” one batch at a time. In gnuplot format, each call
+    // writes a separate data block; in CSV format, rows are tagged with
+    // “index” so that several polynomials can share a file.
+    void plot_error(std::ostream &os, format fmt, int samples, int index);
+
+    // Gnuplot script for a data file written by plot_error() with “blocks”
+    // calls, marking the control points and zeros of the current estimate.
+    void plot_script(std::ostream &os, format fmt, std::string const &data, int blocks) const;
+
     bool show_stats = false;
     bool show_debug = false;
 
@@ -70,18 +106,22 @@ private:
     void remez_step();
 
     void find_zeros();
+    void find_zeros_serial();
+    void find_zeros_ksection(int k);
     void find_extrema();
+    void find_extrema_serial();
+    void find_extrema_ksection(int k);
 
-    void worker_thread();
+    int do_job(int i);
 
-    lol::real eval_estimate(lol::real const &x);
-    lol::real eval_func(lol::real const &x);
-    lol::real eval_weight(lol::real const &x);
-    lol::real eval_error(lol::real const &x);
+    lol::real eval_estimate(lol::real const &x) const;
+    lol::real eval_func(lol::real const &x) const;
+    lol::real eval_weight(lol::real const &x) const;
+    lol::real eval_error(lol::real const &x) const;
 
 private:
     /* User-defined parameters */
-    expression m_func, m_weight;
+    std::function<lol::real(lol::real const &)> m_func, m_weight;
     lol::real m_xmin = -lol::real::R_1();
     lol::real m_xmax = +lol::real::R_1();
     int m_order = 4;
@@ -91,6 +131,7 @@ private:
 
     /* Solver state */
     lol::polynomial<lol::real> m_estimate;
+    std::vector<lol::real> m_chebyshev;
 
     std::vector<lol::real> m_zeros;
     std::vector<lol::real> m_control;
@@ -105,8 +146,16 @@ private:
     std::vector<std::array<point, 3>> m_zeros_state;
     std::vector<std::array<point, 3>> m_extrema_state;
 
+    /* Points evaluated in the current round of each bracket, when several
+     * workers share a bracket */
+    std::vector<point> m_section;
+
+    /* Error plotting state: first sample index of each job, and results */
+    std::vector<int> m_plot_start;
+    std::vector<lol::real> m_plot_values;
+    int m_plot_samples = 0;
+
     /* Threading information */
-    std::vector<lol::thread *> m_workers;
-    lol::queue<int> m_questions, m_answers;
+    worker_pool::client m_pool;
 };
 
@@ -0,0 +1,255 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <cstdint>
+#include <fstream>
+
+#include <lol/real>
+#include <lol/math>
+
+#include "table.h"
+
+using lol::real;
+
+static uint64_t align64(uint64_t offset)
+{
+    return (offset + 63) & ~uint64_t(63);
+}
+
+template<typename T>
+static void put(std::ostream &os, T const &value)
+{
+    os.write(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+static void put_coeff(std::ostream &os, real const &x, number_type type)
+{
+    switch (type)
+    {
+    case number_type::float32: put(os, float(round_to(x, type))); break;
+    case number_type::float64: put(os, double(round_to(x, type))); break;
+    case number_type::float16:
+    case number_type::bfloat16: put(os, uint16_t(encode16(x, type))); break;
+    default: break;
+    }
+}
+
+bool write_table(std::string const &path, number_type type,
+                 real const &xmin, real const &xmax,
+                 std::vector<table_segment> const &segments)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t const degree = uint32_t(segments[0].p.degree());
+    uint32_t const count = uint32_t(segments.size());
+    uint32_t const size = uint32_t(get_target_info(type).bits / 8);
+    uint64_t const index = 64;
+    uint64_t const coeffs = align64(index + 32 * uint64_t(count));
+
+    file.write("LOLREMEZ", 8);
+    put(file, uint32_t(1));
+    put(file, uint32_t(0x01020304));
+    put(file, uint32_t(type));
+    put(file, size);
+    put(file, degree);
+    put(file, count);
+    put(file, double(xmin));
+    put(file, double(xmax));
+    put(file, index);
+    put(file, coeffs);
+
+    for (uint32_t k = 0; k < count; ++k)
+    {
+        auto const &s = segments[k];
+        put(file, double(s.lo));
+        put(file, double(s.hi));
+        put(file, double(s.center));
+        put(file, coeffs + uint64_t(k) * (degree + 1) * size);
+    }
+
+    for (uint64_t offset = index + 32 * uint64_t(count); offset < coeffs; ++offset)
+        file.put(0);
+
+    for (auto const &s : segments)
+        for (uint32_t j = 0; j <= degree; ++j)
+            put_coeff(file, s.p[j], type);
+
+    return bool(file);
+}
+
+// The loader, with placeholders for the table name, storage type, type
+// used for arithmetic, and number type identifier
+static char const *loader = R"(#pragma once
+
+// Loader for lolremez coefficient tables, format version 1. The file is
+// mapped into memory and never copied, so opening a table takes the same
+// time regardless of its size.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if _WIN32
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+class @NAME@_table
+{
+public:
+    typedef @TYPE@ value_type;
+
+    @NAME@_table() = default;
+    @NAME@_table(@NAME@_table const &) = delete;
+    @NAME@_table &operator =(@NAME@_table const &) = delete;
+    ~@NAME@_table() { close(); }
+
+    // Returns false if the file cannot be mapped, or is not a table of
+    // value_type in this machine’s byte order
+    bool open(char const *path)
+    {
+        close();
+#if _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size)
+                       ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        m_data = static_cast<char const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = size_t(size.QuadPart);
+        CloseHandle(mapping);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        void *data = fstat(fd, &st) == 0 && st.st_size > 0
+                   ? mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+        m_data = static_cast<char const *>(data);
+        m_size = size_t(st.st_size);
+#endif
+        if (m_data && check_header())
+            return true;
+        close();
+        return false;
+    }
+
+    void close()
+    {
+        if (m_data)
+#if _WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(const_cast<char *>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    size_t size() const { return m_count; }
+    size_t degree() const { return m_degree; }
+    double xmin() const { return m_xmin; }
+    double xmax() const { return m_xmax; }
+
+    // Segment containing x, since segments are evenly spaced
+    size_t find(double x) const
+    {
+        double const k = (x - m_xmin) / (m_xmax - m_xmin) * double(m_count);
+        return k <= 0 ? 0 : k >= double(m_count - 1) ? m_count - 1 : size_t(k);
+    }
+
+    // Evaluate segment k at x, reading its coefficients in place
+    value_type eval(size_t k, value_type x) const
+    {
+        double center;
+        memcpy(&center, m_data + m_index + 32 * k + 16, sizeof(center));
+        value_type const *c = reinterpret_cast<value_type const *>(m_data + m_coeffs)
+                            + k * (m_degree + 1);
+
+        @CTYPE@ const t = @CTYPE@(x) - @CTYPE@(center);
+        @CTYPE@ u = @CTYPE@(c[m_degree]);
+        for (size_t j = m_degree; j-- > 0; )
+            u = u * t + @CTYPE@(c[j]);
+        return value_type(u);
+    }
+
+    value_type operator ()(value_type x) const
+    {
+        return eval(find(double(x)), x);
+    }
+
+private:
+    // Only the fixed-size header is checked, not the segments
+    bool check_header()
+    {
+        uint32_t u[6];
+        uint64_t offsets[2];
+        if (m_size < 64 || memcmp(m_data, "LOLREMEZ", 8) != 0)
+            return false;
+        memcpy(u, m_data + 8, sizeof(u));
+        memcpy(&m_xmin, m_data + 32, sizeof(m_xmin));
+        memcpy(&m_xmax, m_data + 40, sizeof(m_xmax));
+        memcpy(offsets, m_data + 48, sizeof(offsets));
+        if (u[0] != 1 || u[1] != 0x01020304 || u[2] != @TYPEID@ || u[3] != sizeof(value_type))
+            return false;
+
+        m_degree = u[4];
+        m_count = u[5];
+        m_index = size_t(offsets[0]);
+        m_coeffs = size_t(offsets[1]);
+        uint64_t const coeffs = uint64_t(m_degree + 1) * m_count * sizeof(value_type);
+        return m_count > 0 && m_index % 8 == 0 && m_coeffs % sizeof(value_type) == 0
+                && offsets[0] + 32 * uint64_t(m_count) <= m_size
+                && offsets[1] + coeffs <= m_size;
+    }
+
+    char const *m_data = nullptr;
+    size_t m_size = 0, m_count = 0, m_degree = 0, m_index = 0, m_coeffs = 0;
+    double m_xmin = 0, m_xmax = 0;
+};
+)";
+
+void emit_loader(std::ostream &os, number_type type, std::string const &name)
+{
+    auto const &info = get_target_info(type);
+    std::string ret = loader;
+
+    auto replace = [&](std::string const &key, std::string const &value)
+    {
+        for (size_t pos; (pos = ret.find(key)) != std::string::npos; )
+            ret.replace(pos, key.size(), value);
+    };
+
+    replace("@NAME@", name);
+    replace("@TYPE@", info.name);
+    replace("@CTYPE@", get_target_info(info.compute).name);
+    replace("@TYPEID@", std::to_string(int(type)));
+    os << ret;
+}
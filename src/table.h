@@ -0,0 +1,65 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// Binary coefficient tables
+// -------------------------
+//
+// A piecewise approximation is written as a binary file that consumers
+// map into memory, together with a header-only loader. All fields are in
+// native byte order, which the loader checks. Version 1 layout:
+//
+//   offset  size  field
+//        0     8  magic “LOLREMEZ”
+//        8     4  version (1)
+//       12     4  byte order mark (0x01020304)
+//       16     4  number type (0 float, 1 double, 3 _Float16, 4 __bf16)
+//       20     4  coefficient size in bytes
+//       24     4  degree d
+//       28     4  segment count n
+//       32     8  xmin (double)
+//       40     8  xmax (double)
+//       48     8  offset of the segment index
+//       56     8  offset of the coefficients
+//
+// The index, at a 64-byte aligned offset, has n entries of 32 bytes:
+// segment bounds lo and hi, centre c (doubles), and the offset of the
+// segment’s coefficients. The coefficients, also 64-byte aligned, are
+// packed: d + 1 values per segment in increasing degree order, for a
+// polynomial in t = x - c.
+//
+
+#include <lol/math>
+#include <lol/real>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "target.h"
+
+struct table_segment
+{
+    lol::real lo, hi, center;
+    lol::polynomial<lol::real> p; // in t = x - center
+};
+
+// Write the table file; returns false on I/O errors
+bool write_table(std::string const &path, number_type type,
+                 lol::real const &xmin, lol::real const &xmax,
+                 std::vector<table_segment> const &segments);
+
+// Header-only C++ loader for tables of the given type, mapping the file
+// into memory and evaluating segments in place
+void emit_loader(std::ostream &os, number_type type, std::string const &name);
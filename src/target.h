@@ -0,0 +1,171 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// Target number types
+// -------------------
+//
+// Describes the floating-point types the generated code can use, and
+// how coefficients get rounded when stored in these types. The 16-bit
+// types are storage formats only: the generated code evaluates in float,
+// with coefficients that are exactly representable in the storage type.
+//
+
+#include <lol/real>
+
+#include <float.h>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+enum class number_type
+{
+    float32,
+    float64,
+    long_double,
+    float16,
+    bfloat16,
+};
+
+struct target_info
+{
+    // C type name and literal suffix
+    char const *name, *suffix;
+    // Number of mantissa bits, including the implicit leading bit
+    int mantissa;
+    // Smallest exponent e such that 2^(e-1) is normal
+    int min_exp;
+    // Decimal digits required for the solver, and for round-tripping
+    // literals through a C compiler
+    int digits, literal_digits;
+    // Size in bits, and type used for arithmetic
+    int bits;
+    number_type compute;
+};
+
+static inline target_info const &get_target_info(number_type t)
+{
+    // https://en.wikipedia.org/wiki/Floating-point_arithmetic#Internal_representation
+    // https://en.wikipedia.org/wiki/Half-precision_floating-point_format
+    // https://en.wikipedia.org/wiki/Bfloat16_floating-point_format
+    static target_info const info[] =
+    {
+        { "float", "f", FLT_MANT_DIG, FLT_MIN_EXP, FLT_DIG + 2, FLT_DECIMAL_DIG,
+          32, number_type::float32 },
+        { "double", "", DBL_MANT_DIG, DBL_MIN_EXP, DBL_DIG + 2, DBL_DECIMAL_DIG,
+          64, number_type::float64 },
+        { "long double", "l", LDBL_MANT_DIG, LDBL_MIN_EXP, LDBL_DIG + 2, LDBL_DECIMAL_DIG,
+          int(sizeof(long double) * 8), number_type::long_double },
+        // Literals are float literals, since that is the arithmetic type
+        { "_Float16", "f", 11, -13, 3 + 2, FLT_DECIMAL_DIG, 16, number_type::float32 },
+        { "__bf16", "f", 8, FLT_MIN_EXP, 2 + 2, FLT_DECIMAL_DIG, 16, number_type::float32 },
+    };
+
+    return info[int(t)];
+}
+
+// Size of one unit in the last place of x in the target type, with
+// gradual underflow taken into account.
+static inline lol::real ulp(lol::real const &x, number_type t)
+{
+    auto const &info = get_target_info(t);
+    int e = info.min_exp;
+    if (!x.is_zero())
+    {
+        frexp(x, &e);
+        e = e < info.min_exp ? info.min_exp : e;
+    }
+    return ldexp(lol::real::R_1(), e - info.mantissa);
+}
+
+// Round x to the target type, with ties to even like the hardware and the
+// compiler; subnormal numbers matter for the 16-bit types, whose exponent
+// range is small.
+static inline lol::real round_to(lol::real const &x, number_type t)
+{
+    lol::real const unit = ulp(x, t);
+    lol::real const half = lol::real::R_1() / 2;
+    lol::real const q = x / unit, r = floor(q);
+    bool const up = q - r > half || (q - r == half && !fmod(r, 2).is_zero());
+    return (up ? r + 1 : r) * unit;
+}
+
+// Value of a 16-bit floating-point pattern, or false for infinities and NaNs
+static inline bool decode16(unsigned bits, number_type t, lol::real &x)
+{
+    auto const &info = get_target_info(t);
+    int const mbits = info.mantissa - 1, ebits = 15 - mbits;
+    int const bias = (1 << (ebits - 1)) - 1;
+    int const e = (bits >> mbits) & ((1 << ebits) - 1);
+    int const m = bits & ((1 << mbits) - 1);
+
+    if (e == (1 << ebits) - 1)
+        return false;
+    x = e ? ldexp(lol::real((1 << mbits) + m), e - bias - mbits)
+          : ldexp(lol::real(m), 1 - bias - mbits);
+    if (bits & 0x8000)
+        x = -x;
+    return true;
+}
+
+// 16-bit floating-point pattern of x, after rounding; overflows to infinity
+static inline unsigned encode16(lol::real const &x, number_type t)
+{
+    auto const &info = get_target_info(t);
+    int const mbits = info.mantissa - 1, ebits = 15 - mbits;
+    int const bias = (1 << (ebits - 1)) - 1;
+    unsigned const sign = x.is_negative() ? 0x8000 : 0;
+    lol::real const a = fabs(round_to(x, t));
+
+    if (a.is_zero())
+        return sign;
+
+    int e;
+    frexp(a, &e);
+    int const be = e - 1 + bias;
+    if (be >= (1 << ebits) - 1)
+        return sign | (((1u << ebits) - 1) << mbits);
+    if (be <= 0)
+        return sign | unsigned(double(ldexp(a, bias - 1 + mbits)));
+    return sign | (unsigned(be) << mbits) | (unsigned(double(ldexp(a, mbits - e + 1))) - (1u << mbits));
+}
+
+// Format a coefficient as a C literal of the target type. The value is
+// rounded first, and printed with enough digits to round-trip through the
+// compiler, which is what the error analysis assumes.
+static inline std::string format_literal(lol::real const &x, number_type t,
+                                         bool hex = false)
+{
+    auto const &info = get_target_info(t);
+    lol::real const c = round_to(x, t);
+
+    std::ostringstream ss;
+    ss << std::setprecision(info.literal_digits);
+    if (hex)
+        ss << std::hexfloat;
+    switch (t)
+    {
+        case number_type::float16:
+        case number_type::bfloat16:
+        case number_type::float32: ss << float(c); break;
+        case number_type::float64: ss << double(c); break;
+        case number_type::long_double: ss << (long double)c; break;
+    }
+
+    // “1f” is not a valid literal, but “1.0f” is
+    std::string ret = ss.str();
+    if (ret.find_first_of(".enx") == std::string::npos)
+        ret += ".0";
+    return ret + info.suffix;
+}
@@ -0,0 +1,499 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// Interval arithmetic and Taylor series
+// -------------------------------------
+//
+// Enclosures of a function and of its Taylor coefficients, valid for all
+// inputs in an interval, so that errors can be bounded over a whole range
+// of inputs at once. The bounds are computed in the working precision of
+// lol::real, hundreds of bits beyond that of the target types, and their
+// own rounding errors are neglected.
+//
+
+#include <lol/real>
+
+#include <algorithm> // std::max
+#include <vector>
+
+struct interval
+{
+    interval() = default;
+    interval(lol::real const &x) : lo(x), hi(x) {}
+    interval(lol::real const &a, lol::real const &b) : lo(a), hi(b) {}
+
+    bool contains(lol::real const &x) const { return lo <= x && x <= hi; }
+
+    // Largest and smallest absolute values
+    lol::real mag() const { return max(fabs(lo), fabs(hi)); }
+    lol::real mig() const
+    {
+        return contains(lol::real::R_0()) ? lol::real::R_0() : min(fabs(lo), fabs(hi));
+    }
+
+    lol::real lo, hi;
+};
+
+inline interval operator -(interval const &a)
+{
+    return interval(-a.hi, -a.lo);
+}
+
+inline interval operator +(interval const &a, interval const &b)
+{
+    return interval(a.lo + b.lo, a.hi + b.hi);
+}
+
+inline interval operator -(interval const &a, interval const &b)
+{
+    return interval(a.lo - b.hi, a.hi - b.lo);
+}
+
+inline interval operator *(interval const &a, interval const &b)
+{
+    lol::real const p0 = a.lo * b.lo, p1 = a.lo * b.hi, p2 = a.hi * b.lo, p3 = a.hi * b.hi;
+    return interval(min(min(p0, p1), min(p2, p3)), max(max(p0, p1), max(p2, p3)));
+}
+
+// The divisor must not contain zero
+inline interval operator /(interval const &a, interval const &b)
+{
+    return a * interval(lol::real::R_1() / b.hi, lol::real::R_1() / b.lo);
+}
+
+// Same as a * a, without losing the sign information
+inline interval sqr(interval const &a)
+{
+    return interval(a.mig() * a.mig(), a.mag() * a.mag());
+}
+
+// Number of points π/2 + nπ in a, at most 2, and the first n
+inline int half_pi_points(interval const &a, lol::real &n)
+{
+    lol::real const pi = lol::real::R_PI();
+    n = ceil((a.lo - pi / 2) / pi);
+    lol::real const last = floor((a.hi - pi / 2) / pi);
+    return last < n ? 0 : last == n ? 1 : 2;
+}
+
+// sin reaches 1 at π/2 + 2nπ and -1 at -π/2 + 2nπ
+inline interval sin(interval const &a)
+{
+    lol::real n;
+    int const points = half_pi_points(a, n);
+    if (points == 2)
+        return interval(-lol::real::R_1(), lol::real::R_1());
+
+    lol::real lo = min(sin(a.lo), sin(a.hi)), hi = max(sin(a.lo), sin(a.hi));
+    if (points == 1)
+    {
+        if (fmod(n, lol::real::R_2()).is_zero())
+            hi = lol::real::R_1();
+        else
+            lo = -lol::real::R_1();
+    }
+    return interval(lo, hi);
+}
+
+inline interval cos(interval const &a)
+{
+    return sin(a + interval(lol::real::R_PI() / 2));
+}
+
+inline interval cosh(interval const &a)
+{
+    return interval(cosh(a.mig()), cosh(a.mag()));
+}
+
+// Monotonic functions only need to be evaluated at both ends
+#define INCREASING(f) \
+    inline interval f(interval const &a) { return interval(f(a.lo), f(a.hi)); }
+#define DECREASING(f) \
+    inline interval f(interval const &a) { return interval(f(a.hi), f(a.lo)); }
+
+INCREASING(exp) INCREASING(expm1) INCREASING(log) INCREASING(log1p)
+INCREASING(sqrt) INCREASING(cbrt) INCREASING(tan) INCREASING(asin)
+INCREASING(atan) INCREASING(sinh) INCREASING(tanh) INCREASING(erf)
+DECREASING(acos) DECREASING(erfc) DECREASING(erfcx)
+
+#undef INCREASING
+#undef DECREASING
+
+//
+// Truncated Taylor series Σ c_k·t^k of a function of x = x0 + t. When x0
+// is an interval, each c_k encloses f⁽ᵏ⁾(ξ)/k! for all ξ in x0, which is
+// what the Lagrange remainder needs. Constants only have c_0; operations
+// outside the domain of a function, such as the log of an interval that
+// contains zero, make the series invalid.
+//
+
+struct taylor
+{
+    taylor() = default;
+    taylor(lol::real const &x) : c(1, interval(x)) {}
+
+    // The variable x = x0 + t, to the given order
+    static taylor variable(interval const &x0, int order)
+    {
+        taylor ret;
+        ret.c.assign(order + 1, interval(lol::real::R_0()));
+        ret.c[0] = x0;
+        if (order > 0)
+            ret.c[1] = interval(lol::real::R_1());
+        return ret;
+    }
+
+    interval coeff(size_t k) const
+    {
+        return k < c.size() ? c[k] : interval(lol::real::R_0());
+    }
+
+    std::vector<interval> c;
+    bool valid = true;
+};
+
+// Zero series as long as the longest of a and b
+inline taylor zero_like(taylor const &a, taylor const &b = taylor(lol::real::R_0()))
+{
+    taylor ret;
+    ret.c.assign(std::max(a.c.size(), b.c.size()), interval(lol::real::R_0()));
+    ret.valid = a.valid && b.valid;
+    return ret;
+}
+
+inline taylor invalid(taylor const &a)
+{
+    taylor ret = a;
+    ret.valid = false;
+    return ret;
+}
+
+inline taylor operator -(taylor const &a)
+{
+    taylor ret = a;
+    for (auto &x : ret.c)
+        x = -x;
+    return ret;
+}
+
+inline taylor operator +(taylor const &a, taylor const &b)
+{
+    taylor ret = zero_like(a, b);
+    for (size_t k = 0; k < ret.c.size(); ++k)
+        ret.c[k] = a.coeff(k) + b.coeff(k);
+    return ret;
+}
+
+inline taylor operator -(taylor const &a, taylor const &b)
+{
+    return a + -b;
+}
+
+inline taylor operator *(taylor const &a, taylor const &b)
+{
+    taylor ret = zero_like(a, b);
+    for (size_t k = 0; k < ret.c.size(); ++k)
+        for (size_t j = 0; j <= k; ++j)
+            ret.c[k] = ret.c[k] + a.coeff(j) * b.coeff(k - j);
+    return ret;
+}
+
+inline taylor sqr(taylor const &a)
+{
+    taylor ret = a * a;
+    ret.c[0] = sqr(a.c[0]);
+    return ret;
+}
+
+// w = a / b, so that a_k = Σ b_j·w_{k-j}
+inline taylor operator /(taylor const &a, taylor const &b)
+{
+    taylor ret = zero_like(a, b);
+    if (b.c[0].contains(lol::real::R_0()))
+        return invalid(ret);
+
+    for (size_t k = 0; k < ret.c.size(); ++k)
+    {
+        interval s = a.coeff(k);
+        for (size_t j = 1; j <= k; ++j)
+            s = s - b.coeff(j) * ret.c[k - j];
+        ret.c[k] = s / b.c[0];
+    }
+    return ret;
+}
+
+// Series of u′, one order lower
+inline taylor derivative(taylor const &u)
+{
+    taylor ret = zero_like(u);
+    ret.c.pop_back();
+    for (size_t k = 1; k < u.c.size(); ++k)
+        ret.c[k - 1] = u.c[k] * interval(lol::real(int(k)));
+    if (ret.c.empty())
+        ret.c.push_back(interval(lol::real::R_0()));
+    return ret;
+}
+
+// F(u) where F(u0) is w0 and F′(u) is the series g: w = w0 + ∫ g·u′
+inline taylor compose(taylor const &u, interval const &w0, taylor const &g)
+{
+    taylor const d = g * derivative(u);
+    taylor ret = zero_like(u);
+    ret.valid = u.valid && g.valid;
+    ret.c[0] = w0;
+    for (size_t k = 1; k < ret.c.size(); ++k)
+        ret.c[k] = d.coeff(k - 1) / interval(lol::real(int(k)));
+    return ret;
+}
+
+// Same, when F′(u) also depends on F(u): g(w, i) must only use w_0…w_i,
+// then k·w_k = Σ j·u_j·g_{k-j}
+template<typename G>
+inline taylor compose(taylor const &u, interval const &w0, G const &g)
+{
+    taylor ret = u;
+    ret.c[0] = w0;
+    std::vector<interval> gs;
+    for (size_t k = 1; k < ret.c.size(); ++k)
+    {
+        gs.push_back(g(ret, k - 1));
+        interval s(lol::real::R_0());
+        for (size_t j = 1; j <= k; ++j)
+            s = s + u.c[j] * gs[k - j] * interval(lol::real(int(j)));
+        ret.c[k] = s / interval(lol::real(int(k)));
+    }
+    return ret;
+}
+
+// Σ a_l·b_{i-l}, the coefficient of degree i of a·b
+inline interval convolve(taylor const &a, taylor const &b, size_t i)
+{
+    interval s(lol::real::R_0());
+    for (size_t l = 0; l <= i; ++l)
+        s = s + a.coeff(l) * b.coeff(i - l);
+    return s;
+}
+
+inline taylor exp(taylor const &u)
+{
+    return compose(u, exp(u.c[0]), [](taylor const &w, size_t i) { return w.c[i]; });
+}
+
+inline taylor expm1(taylor const &u)
+{
+    taylor ret = exp(u);
+    ret.c[0] = expm1(u.c[0]);
+    return ret;
+}
+
+inline taylor exp2(taylor const &u)
+{
+    return exp(u * taylor(log(lol::real::R_2())));
+}
+
+inline taylor log(taylor const &u)
+{
+    if (u.c[0].lo <= lol::real::R_0())
+        return invalid(u);
+    return compose(u, log(u.c[0]), taylor(lol::real::R_1()) / u);
+}
+
+inline taylor log1p(taylor const &u)
+{
+    if (u.c[0].lo <= -lol::real::R_1())
+        return invalid(u);
+    return compose(u, log1p(u.c[0]), taylor(lol::real::R_1()) / (u + taylor(lol::real::R_1())));
+}
+
+inline taylor log2(taylor const &u)
+{
+    return log(u) * taylor(lol::real::R_1() / log(lol::real::R_2()));
+}
+
+inline taylor log10(taylor const &u)
+{
+    return log(u) * taylor(lol::real::R_1() / log(lol::real::R_10()));
+}
+
+// u^a for a constant a, if u does not contain zero:
+// k·u_0·w_k = Σ ((a + 1)·j - k)·u_j·w_{k-j}
+inline taylor power(taylor const &u, lol::real const &a, interval const &w0)
+{
+    taylor ret = u;
+    if (u.c[0].contains(lol::real::R_0()))
+        return invalid(ret);
+
+    ret.c[0] = w0;
+    for (size_t k = 1; k < ret.c.size(); ++k)
+    {
+        interval s(lol::real::R_0());
+        for (size_t j = 1; j <= k; ++j)
+            s = s + u.c[j] * ret.c[k - j] * interval((a + 1) * int(j) - int(k));
+        ret.c[k] = s / (u.c[0] * interval(lol::real(int(k))));
+    }
+    return ret;
+}
+
+inline taylor sqrt(taylor const &u)
+{
+    if (u.c[0].lo <= lol::real::R_0())
+        return invalid(u);
+    return power(u, lol::real::R_1() / 2, sqrt(u.c[0]));
+}
+
+inline taylor cbrt(taylor const &u)
+{
+    return power(u, lol::real::R_1() / 3, cbrt(u.c[0]));
+}
+
+inline taylor pow(taylor const &u, taylor const &v)
+{
+    // Integer exponents work for any sign of u, by repeated squaring
+    lol::real const e = v.c[0].lo;
+    if (v.c.size() == 1 && v.c[0].hi == e && e == round(e) && fabs(e) <= lol::real(64))
+    {
+        taylor ret(lol::real::R_1()), base = u;
+        ret.valid = u.valid;
+        for (int n = int(fabs(e)); n; n /= 2, base = sqr(base))
+            if (n & 1)
+                ret = ret * base;
+        return e < lol::real::R_0() ? taylor(lol::real::R_1()) / ret : ret;
+    }
+
+    if (u.c[0].lo <= lol::real::R_0())
+        return invalid(zero_like(u, v));
+    if (v.c.size() == 1 && v.c[0].hi == e)
+    {
+        lol::real const a = pow(u.c[0].lo, e), b = pow(u.c[0].hi, e);
+        return power(u, e, interval(min(a, b), max(a, b)));
+    }
+    return exp(v * log(u));
+}
+
+// sin and cos, or sinh and cosh, need each other’s coefficients
+inline void sincos(taylor const &u, taylor &s, taylor &c, bool hyperbolic)
+{
+    s = c = u;
+    s.c[0] = hyperbolic ? sinh(u.c[0]) : sin(u.c[0]);
+    c.c[0] = hyperbolic ? cosh(u.c[0]) : cos(u.c[0]);
+    for (size_t k = 1; k < u.c.size(); ++k)
+    {
+        interval ss(lol::real::R_0()), cc(lol::real::R_0());
+        for (size_t j = 1; j <= k; ++j)
+        {
+            interval const uj = u.c[j] * interval(lol::real(int(j)));
+            ss = ss + uj * c.c[k - j];
+            cc = cc + uj * s.c[k - j];
+        }
+        s.c[k] = ss / interval(lol::real(int(k)));
+        c.c[k] = (hyperbolic ? cc : -cc) / interval(lol::real(int(k)));
+    }
+}
+
+inline taylor sin(taylor const &u)
+{
+    taylor s, c;
+    sincos(u, s, c, false);
+    return s;
+}
+
+inline taylor cos(taylor const &u)
+{
+    taylor s, c;
+    sincos(u, s, c, false);
+    return c;
+}
+
+inline taylor sinh(taylor const &u)
+{
+    taylor s, c;
+    sincos(u, s, c, true);
+    return s;
+}
+
+inline taylor cosh(taylor const &u)
+{
+    taylor s, c;
+    sincos(u, s, c, true);
+    return c;
+}
+
+// tan′ = 1 + tan², tanh′ = 1 - tanh²
+inline taylor tan(taylor const &u)
+{
+    lol::real n;
+    if (half_pi_points(u.c[0], n))
+        return invalid(u);
+    return compose(u, tan(u.c[0]), [](taylor const &w, size_t i)
+    {
+        return i ? convolve(w, w, i) : interval(lol::real::R_1()) + sqr(w.c[0]);
+    });
+}
+
+inline taylor tanh(taylor const &u)
+{
+    return compose(u, tanh(u.c[0]), [](taylor const &w, size_t i)
+    {
+        return i ? -convolve(w, w, i) : interval(lol::real::R_1()) - sqr(w.c[0]);
+    });
+}
+
+inline taylor asin(taylor const &u)
+{
+    if (u.c[0].mag() >= lol::real::R_1())
+        return invalid(u);
+    return compose(u, asin(u.c[0]), taylor(lol::real::R_1()) / sqrt(taylor(lol::real::R_1()) - sqr(u)));
+}
+
+inline taylor acos(taylor const &u)
+{
+    if (u.c[0].mag() >= lol::real::R_1())
+        return invalid(u);
+    return compose(u, acos(u.c[0]), taylor(-lol::real::R_1()) / sqrt(taylor(lol::real::R_1()) - sqr(u)));
+}
+
+inline taylor atan(taylor const &u)
+{
+    return compose(u, atan(u.c[0]), taylor(lol::real::R_1()) / (taylor(lol::real::R_1()) + sqr(u)));
+}
+
+// erf′(u) = 2/√π·exp(-u²)
+inline taylor erf(taylor const &u)
+{
+    lol::real const k = lol::real::R_2() / sqrt(lol::real::R_PI());
+    return compose(u, erf(u.c[0]), taylor(k) * exp(-sqr(u)));
+}
+
+inline taylor erfc(taylor const &u)
+{
+    lol::real const k = lol::real::R_2() / sqrt(lol::real::R_PI());
+    return compose(u, erfc(u.c[0]), taylor(-k) * exp(-sqr(u)));
+}
+
+// erfcx′(u) = 2u·erfcx(u) - 2/√π
+inline taylor erfcx(taylor const &u)
+{
+    lol::real const k = lol::real::R_2() / sqrt(lol::real::R_PI());
+    return compose(u, erfcx(u.c[0]), [&u, k](taylor const &w, size_t i)
+    {
+        interval const s = convolve(u, w, i) * interval(lol::real::R_2());
+        return i ? s : s - interval(k);
+    });
+}
+
+inline taylor fabs(taylor const &u)
+{
+    return u.c[0].lo > lol::real::R_0() ? u : u.c[0].hi < lol::real::R_0() ? -u : invalid(u);
+}
@@ -0,0 +1,362 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#if HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <algorithm> // std::min
+#include <functional>
+
+#include <lol/real>
+
+#include "ttcross.h"
+
+using lol::real;
+
+/* Kinds of worker jobs: scanning superblock row r is job r of scan_job,
+ * sampling it is job r of sample_job, and checking chunk c of the check
+ * points is job c of check_job. */
+static int const scan_job = 0;
+static int const sample_job = 1;
+static int const check_job = 2;
+static int const chunk = 16;
+
+tt_cross_solver::tt_cross_solver(function const &f, std::vector<real> const &min,
+                                 std::vector<real> const &max, int grid_size, int max_rank)
+  : m_func(f),
+    m_grid_size(grid_size),
+    m_max_rank(max_rank),
+    m_min(min),
+    m_max(max),
+    m_pool([this](int i) { return do_job(i); })
+{
+    int const d = (int)min.size();
+    assert(d >= 2 && max.size() == min.size());
+
+    // Chebyshev extrema for sampling
+    m_grids.resize(d);
+    for (int k = 0; k < d; ++k)
+        for (int i = 0; i <= grid_size; ++i)
+            m_grids[k].push_back(min[k] + (max[k] - min[k])
+                                   * (real::R_1() - cos(real::R_PI() * i / grid_size)) / 2);
+
+    // The first pivot is the largest |f| found by searching along each
+    // variable in turn, starting from the middle of the grid; this only
+    // costs a few lines, so it is done here.
+    std::vector<int> start(d, grid_size / 2);
+    std::vector<real> xs(d);
+    for (int k = 0; k < d; ++k)
+        xs[k] = m_grids[k][start[k]];
+    real val = m_func(xs);
+
+    for (int pass = 0; pass < 2; ++pass)
+        for (int k = 0; k < d; ++k)
+        {
+            std::vector<real> line = xs;
+            for (int i = 0; i <= grid_size; ++i)
+            {
+                line[k] = m_grids[k][i];
+                real const v = m_func(line);
+                if (fabs(v) > fabs(val))
+                {
+                    val = v;
+                    start[k] = i;
+                }
+            }
+            xs[k] = m_grids[k][start[k]];
+        }
+
+    m_grid_error = fabs(val);
+
+    m_left.resize(d - 1);
+    m_right.resize(d - 1);
+    for (int k = 0; k < d - 1; ++k)
+    {
+        m_left[k].push_back({ 0, start[k], std::vector<real>(xs.begin(), xs.begin() + k + 1) });
+        m_right[k].push_back({ 0, start[k + 1], std::vector<real>(xs.begin() + k + 1, xs.end()) });
+        m_inverse.emplace_back(1);
+        m_inverse[k][0][0] = val.is_zero() ? real::R_0() : real::R_1() / val;
+    }
+}
+
+int tt_cross_solver::rank(int k) const
+{
+    return k < 0 || k >= dimensions() - 1 ? 1 : (int)m_left[k].size();
+}
+
+int tt_cross_solver::sweep(real const &tolerance)
+{
+    int const bonds = dimensions() - 1;
+    int added = 0;
+
+    m_grid_error = real::R_0();
+    for (int n = 0; n < bonds; ++n)
+        visit(m_forward ? n : bonds - 1 - n, tolerance, added);
+    m_forward = !m_forward;
+
+    return added;
+}
+
+void tt_cross_solver::visit(int k, real const &tolerance, int &added)
+{
+    int const n = m_grid_size + 1;
+
+    m_bond = k;
+    m_block_rows = rank(k - 1) * n;
+    m_block_cols = rank(k + 1) * n;
+    m_block.resize(m_block_cols, m_block_rows);
+
+    // Superblock row a·n + i is left pivot a of bond k-1 followed by grid
+    // point i, and column b·n + j is grid point j followed by right pivot
+    // b of bond k+1, so the pivots of bond k are rows and columns of it.
+    m_pivot_rows.clear();
+    m_pivot_cols.clear();
+    for (auto const &p : m_left[k])
+        m_pivot_rows.push_back(p.parent * n + p.index);
+    for (auto const &p : m_right[k])
+        m_pivot_cols.push_back(p.parent * n + p.index);
+
+    m_row_col.resize(m_block_rows);
+    m_row_error.resize(m_block_rows);
+    m_pool.run(sample_job, m_block_rows);
+    m_pool.run(scan_job, m_block_rows);
+
+    // Worst point of the superblock, in row order so that the result does
+    // not depend on thread timings
+    int best = 0;
+    for (int r = 1; r < m_block_rows; ++r)
+        if (m_row_error[r] > m_row_error[best])
+            best = r;
+
+    m_grid_error = max(m_grid_error, m_row_error[best]);
+    if (m_row_error[best] <= tolerance || rank(k) >= m_max_rank)
+        return;
+
+    // Add the new pivot; nestedness holds by construction
+    int const a = best / n, i = best % n;
+    int const b = m_row_col[best] / n, j = m_row_col[best] % n;
+
+    pivot left { a, i, k > 0 ? m_left[k - 1][a].coords : std::vector<real>() };
+    left.coords.push_back(m_grids[k][i]);
+
+    pivot right { b, j, { m_grids[k + 1][j] } };
+    if (k + 1 < dimensions() - 1)
+        right.coords.insert(right.coords.end(), m_right[k + 1][b].coords.begin(),
+                            m_right[k + 1][b].coords.end());
+
+    m_left[k].push_back(left);
+    m_right[k].push_back(right);
+    m_pivot_rows.push_back(best);
+    m_pivot_cols.push_back(m_row_col[best]);
+    update_inverse(k);
+    ++added;
+}
+
+// Invert f(I_k,J_k), whose values are in the current superblock
+void tt_cross_solver::update_inverse(int k)
+{
+    int const r = rank(k);
+    linear_system<real> p(r);
+    for (int a = 0; a < r; ++a)
+        for (int b = 0; b < r; ++b)
+            p[a][b] = m_block[m_pivot_rows[a]][m_pivot_cols[b]];
+    m_inverse[k] = p.inverse();
+}
+
+real tt_cross_solver::check_error(int samples)
+{
+    m_check = nullptr;
+    return run_check(samples);
+}
+
+real tt_cross_solver::check_error(int samples, function const &approx)
+{
+    m_check = &approx;
+    real const ret = run_check(samples);
+    m_check = nullptr;
+    return ret;
+}
+
+real tt_cross_solver::run_check(int samples)
+{
+    // Halton sequence, with one prime base per variable
+    static int const primes[] = { 2, 3, 5, 7, 11, 13, 17, 19 };
+
+    m_check_points.resize(samples);
+    for (int n = 0; n < samples; ++n)
+    {
+        m_check_points[n].resize(dimensions());
+        for (int k = 0; k < dimensions(); ++k)
+        {
+            int const base = primes[k % 8];
+            real h(0), scale = real::R_1() / real(base);
+            for (int i = n + 1; i > 0; i /= base, scale /= real(base))
+                h += scale * real(i % base);
+            m_check_points[n][k] = m_min[k] + (m_max[k] - m_min[k]) * h;
+        }
+    }
+
+    m_chunk_error.resize((samples + chunk - 1) / chunk);
+    m_pool.run(check_job, (int)m_chunk_error.size());
+
+    real ret(0);
+    for (auto const &e : m_chunk_error)
+        ret = max(ret, e);
+    return ret;
+}
+
+// T(a,c) = f(I_{k-1}[a], x, J_k[c]), then G_k(x) = T·f(I_k,J_k)⁻¹
+void tt_cross_solver::factor_line(int k, real const &x, array2d<real> &ret) const
+{
+    int const rows = rank(k - 1), cols = rank(k);
+    array2d<real> t(cols, rows);
+
+    for (int a = 0; a < rows; ++a)
+        for (int c = 0; c < cols; ++c)
+        {
+            std::vector<real> xs;
+            if (k > 0)
+                xs = m_left[k - 1][a].coords;
+            xs.push_back(x);
+            if (k < dimensions() - 1)
+                xs.insert(xs.end(), m_right[k][c].coords.begin(), m_right[k][c].coords.end());
+            t[a][c] = m_func(xs);
+        }
+
+    ret.resize(cols, rows);
+    for (int a = 0; a < rows; ++a)
+        for (int b = 0; b < cols; ++b)
+        {
+            if (k == dimensions() - 1)
+            {
+                ret[a][b] = t[a][b];
+                continue;
+            }
+
+            ret[a][b] = real::R_0();
+            for (int c = 0; c < cols; ++c)
+                ret[a][b] += t[a][c] * m_inverse[k][c][b];
+        }
+}
+
+real tt_cross_solver::eval_factor(int k, int a, int b, real const &x) const
+{
+    auto point = [&](int c)
+    {
+        std::vector<real> xs;
+        if (k > 0)
+            xs = m_left[k - 1][a].coords;
+        xs.push_back(x);
+        if (k < dimensions() - 1)
+            xs.insert(xs.end(), m_right[k][c].coords.begin(), m_right[k][c].coords.end());
+        return xs;
+    };
+
+    if (k == dimensions() - 1)
+        return m_func(point(0));
+
+    real ret(0);
+    for (int c = 0; c < rank(k); ++c)
+        ret += m_func(point(c)) * m_inverse[k][c][b];
+    return ret;
+}
+
+real tt_cross_solver::eval(std::vector<real> const &xs) const
+{
+    std::vector<real> v(1, real::R_1());
+    array2d<real> g;
+
+    for (int k = 0; k < dimensions(); ++k)
+    {
+        factor_line(k, xs[k], g);
+        std::vector<real> next(g.cols(), real::R_0());
+        for (size_t a = 0; a < v.size(); ++a)
+            for (size_t b = 0; b < next.size(); ++b)
+                next[b] += v[a] * g[a][b];
+        v = next;
+    }
+
+    return v[0];
+}
+
+// Worker threads handle jobs from the main thread, each on a row of the
+// current superblock or a chunk of check points.
+int tt_cross_solver::do_job(int i)
+{
+    int const n = m_grid_size + 1;
+    int const k = m_bond;
+    int const kind = worker_pool::job_kind(i);
+
+    if (kind == check_job)
+    {
+        int const c = worker_pool::job_index(i);
+        size_t const end = std::min(m_check_points.size(), size_t(c + 1) * chunk);
+        real err(0);
+        for (size_t p = size_t(c) * chunk; p < end; ++p)
+        {
+            auto const &xs = m_check_points[p];
+            real const approx = m_check ? (*m_check)(xs) : eval(xs);
+            err = max(err, fabs(m_func(xs) - approx));
+        }
+        m_chunk_error[c] = err;
+    }
+    else if (kind == sample_job)
+    {
+        int const r = worker_pool::job_index(i), a = r / n;
+        std::vector<real> xs;
+        if (k > 0)
+            xs = m_left[k - 1][a].coords;
+        xs.push_back(m_grids[k][r % n]);
+        xs.push_back(real::R_0());
+        size_t const pos = xs.size() - 1;
+
+        for (int c = 0; c < m_block_cols; ++c)
+        {
+            int const b = c / n;
+            xs.resize(pos + 1);
+            xs[pos] = m_grids[k + 1][c % n];
+            if (k + 1 < dimensions() - 1)
+                xs.insert(xs.end(), m_right[k + 1][b].coords.begin(),
+                          m_right[k + 1][b].coords.end());
+            m_block[r][c] = m_func(xs);
+        }
+    }
+    else
+    {
+        // Error of the cross interpolation on this row:
+        //   e(r,c) = A(r,c) - A(r,J_k)·f(I_k,J_k)⁻¹·A(I_k,c)
+        int const r = worker_pool::job_index(i), size = rank(k);
+        std::vector<real> w(size, real::R_0());
+        for (int q = 0; q < size; ++q)
+            for (int p = 0; p < size; ++p)
+                w[p] += m_block[r][m_pivot_cols[q]] * m_inverse[k][q][p];
+
+        int col = 0;
+        real err(0);
+        for (int c = 0; c < m_block_cols; ++c)
+        {
+            real e = m_block[r][c];
+            for (int p = 0; p < size; ++p)
+                e -= w[p] * m_block[m_pivot_rows[p]][c];
+            if (fabs(e) > err)
+            {
+                err = fabs(e);
+                col = c;
+            }
+        }
+        m_row_col[r] = col;
+        m_row_error[r] = err;
+    }
+
+    return i;
+}
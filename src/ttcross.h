@@ -0,0 +1,126 @@
+//
+//  LolRemez — Remez algorithm implementation
+//
+//  Copyright © 2005–2023 Sam Hocevar <sam@hocevar.net>
+//
+//  This program is free software. It comes without any warranty, to
+//  the extent permitted by applicable law. You can redistribute it
+//  and/or modify it under the terms of the Do What the Fuck You Want
+//  to Public License, Version 2, as published by the WTFPL Task Force.
+//  See http://www.wtfpl.net/ for more details.
+//
+
+#pragma once
+
+//
+// The tt_cross_solver class
+// -------------------------
+//
+// Tensor-train cross approximation of a function of d variables. Between
+// variables k and k+1 there is a set I_k of pivots on the first k+1
+// variables and a set J_k of pivots on the remaining ones, nested so that
+// I_k ⊂ I_{k-1} × grid_k and J_k ⊂ grid_{k+1} × J_{k+1}. Then
+//   f(x_0,…,x_{d-1}) ≈ G_0(x_0)·G_1(x_1)···G_{d-1}(x_{d-1})
+// where G_k(x) = f(I_{k-1},x,J_k)·f(I_k,J_k)⁻¹ is a matrix of univariate
+// functions. Each sweep visits the bonds between variables, samples the
+// “superblock” f(I_{k-1},grid_k,grid_{k+1},J_{k+1}), and adds the point
+// where the current interpolation is worst as a new pivot, so the cost
+// grows with the ranks instead of with the size of the full grid.
+//
+
+#include <lol/real>
+
+#include <functional>
+#include <vector>
+
+#include "matrix.h"
+#include "pool.h"
+
+class tt_cross_solver
+{
+public:
+    typedef std::function<lol::real(std::vector<lol::real> const &)> function;
+
+    // Sample f on a (grid_size + 1)^d Chebyshev grid over the given ranges;
+    // f must be safe to call from several threads
+    tt_cross_solver(function const &f, std::vector<lol::real> const &min,
+                    std::vector<lol::real> const &max, int grid_size, int max_rank);
+
+    // Visit every bond once, alternating directions between calls, and
+    // add a pivot where the superblock error is above tolerance. Returns
+    // the number of pivots added.
+    int sweep(lol::real const &tolerance);
+
+    int dimensions() const { return (int)m_grids.size(); }
+
+    // Rank of the bond between variables k and k+1; the outer bonds, for
+    // k = -1 and k = d-1, have rank 1
+    int rank(int k) const;
+
+    // Largest superblock error seen during the last sweep
+    lol::real grid_error() const { return m_grid_error; }
+
+    // Largest |f - approx| on a quasi-random set of points, where the
+    // solver never looked. Without an approximation, the current cross
+    // approximation is checked.
+    lol::real check_error(int samples);
+    lol::real check_error(int samples, function const &approx);
+
+    // Entry (a,b) of G_k(x), a rank(k-1) × rank(k) matrix
+    lol::real eval_factor(int k, int a, int b, lol::real const &x) const;
+
+    lol::real eval(std::vector<lol::real> const &xs) const;
+
+private:
+    void visit(int k, lol::real const &tolerance, int &added);
+    void update_inverse(int k);
+    lol::real run_check(int samples);
+    void factor_line(int k, lol::real const &x, array2d<lol::real> &ret) const;
+    int do_job(int i);
+
+    function m_func;
+    int m_grid_size, m_max_rank;
+    std::vector<lol::real> m_min, m_max;
+
+    // Chebyshev grid for each variable
+    std::vector<std::vector<lol::real>> m_grids;
+
+    /*
+     * Pivots for each bond k between variables k and k+1. A left pivot is
+     * a pair (a,i): left pivot a of bond k-1 followed by grid point i of
+     * variable k. A right pivot is a pair (j,b): grid point j of variable
+     * k+1 followed by right pivot b of bond k+1. The coordinates are also
+     * kept in full, since they never change once a pivot is added.
+     */
+    struct pivot
+    {
+        int parent, index;
+        std::vector<lol::real> coords;
+    };
+
+    std::vector<std::vector<pivot>> m_left, m_right;
+
+    // f(I_k,J_k)⁻¹ for each bond
+    std::vector<linear_system<lol::real>> m_inverse;
+
+    // Current superblock: its bond, row and column count, samples, and
+    // the positions of the pivots of I_k and J_k in it
+    int m_bond = 0, m_block_rows = 0, m_block_cols = 0;
+    array2d<lol::real> m_block;
+    std::vector<int> m_pivot_rows, m_pivot_cols;
+
+    // Superblock scan results: worst column and error of each row
+    std::vector<int> m_row_col;
+    std::vector<lol::real> m_row_error;
+
+    bool m_forward = true;
+    lol::real m_grid_error;
+
+    // Check points and results, and the approximation being checked
+    std::vector<std::vector<lol::real>> m_check_points;
+    std::vector<lol::real> m_chunk_error;
+    function const *m_check = nullptr;
+
+    /* Threading information */
+    worker_pool::client m_pool;
+};